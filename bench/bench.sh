@@ -0,0 +1,39 @@
+#!/bin/sh
+# Run every given lsv binary on every fixture in vertical, -x and -l
+# mode and append the results to a CSV file.
+#
+# Usage: bench.sh <run_bench binary> <csv file> <lsv binary ...>
+#
+# Environment: FIXTURE_ROOT, FIXTURES (see gen_fixtures.sh), ROUNDS
+# (timed runs per cell, default 3) and MODES (default "vertical -x -l").
+RUN=$1
+CSV=$2
+shift 2
+
+FIXTURE_ROOT=${FIXTURE_ROOT:-/tmp/lsv-fixtures}
+FIXTURES=${FIXTURES:-"flat-10k flat-100k flat-1m prefix-100k mixed-10k deep-256"}
+ROUNDS=${ROUNDS:-3}
+MODES=${MODES:-"vertical -x -l"}
+
+if [ ! -f "$CSV" ]; then
+    echo "date,version,fixture,mode,rounds,wall_ms,syscalls,maxrss_kb,minflt,majflt,status" > "$CSV"
+fi
+
+stamp=$(date -u +%Y-%m-%dT%H:%M:%SZ)
+for bin in "$@"; do
+    version=$(basename "$bin")
+    version=${version#lsv}
+    for fixture in $FIXTURES; do
+        for mode in $MODES; do
+            if [ "$mode" = vertical ]; then
+                line=$("$RUN" "$ROUNDS" "$bin" "$FIXTURE_ROOT/$fixture")
+            else
+                line=$("$RUN" "$ROUNDS" "$bin" "$mode" "$FIXTURE_ROOT/$fixture")
+            fi
+            [ -n "$line" ] || continue
+            echo "$stamp,$version,$fixture,$mode,$ROUNDS,$line" >> "$CSV"
+            printf '%-8s %-12s %-9s %s\n' "$version" "$fixture" "$mode" "$line"
+        done
+    done
+done
+echo "Results appended to $CSV"
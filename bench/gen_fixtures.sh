@@ -0,0 +1,75 @@
+#!/bin/sh
+# Build the benchmark fixture trees under $FIXTURE_ROOT.  Each tree
+# is created once; a .complete marker makes later runs skip it.
+#
+#   flat-10k, flat-100k, flat-1m   empty files f0000001 ...
+#   prefix-100k                    long names sharing a 60-byte prefix
+#   mixed-10k                      files, executables, archives, dot
+#                                  files, directories, symlinks (some
+#                                  dangling) and FIFOs
+#   deep-256                       a 256-level directory chain with
+#                                  8 files per level
+#
+# Usage: gen_fixtures.sh [fixture ...]   (default: $FIXTURES or all)
+FIXTURE_ROOT=${FIXTURE_ROOT:-/tmp/lsv-fixtures}
+ALL="flat-10k flat-100k flat-1m prefix-100k mixed-10k deep-256"
+
+if [ $# -gt 0 ]; then
+    LIST="$*"
+else
+    LIST=${FIXTURES:-$ALL}
+fi
+
+flat() {
+    seq -f "f%07g" 1 "$1" | xargs touch
+}
+
+prefix() {
+    seq -f "dataset_shard_2026_region_eu_west_1_partition_bucket_0000_%07g.parquet" 1 "$1" |
+        xargs touch
+}
+
+mixed() {
+    n=$1
+    awk -v n="$n" 'BEGIN { for (i = 1; i <= n * 0.55; i++) printf "file%06d.txt\n", i }' | xargs touch
+    awk -v n="$n" 'BEGIN { for (i = 1; i <= n * 0.10; i++) printf "tool%06d\n", i }' | xargs touch
+    awk -v n="$n" 'BEGIN { for (i = 1; i <= n * 0.10; i++) printf "tool%06d\n", i }' | xargs chmod +x
+    awk -v n="$n" 'BEGIN { for (i = 1; i <= n * 0.05; i++) printf "backup%06d.tar.gz\n", i }' | xargs touch
+    awk -v n="$n" 'BEGIN { for (i = 1; i <= n * 0.02; i++) printf ".hidden%06d\n", i }' | xargs touch
+    awk -v n="$n" 'BEGIN { for (i = 1; i <= n * 0.10; i++) printf "dir%06d\n", i }' | xargs mkdir
+    awk -v n="$n" 'BEGIN { for (i = 1; i <= n * 0.10; i++)
+        printf "%s link%06d\n", (i % 4 ? sprintf("file%06d.txt", i) : "missing"), i }' |
+        xargs -n 2 ln -s
+    awk -v n="$n" 'BEGIN { for (i = 1; i <= n * 0.03; i++) printf "fifo%06d\n", i }' | xargs mkfifo
+}
+
+deep() {
+    d=.
+    i=0
+    while [ "$i" -lt "$1" ]; do
+        (cd "$d" && seq -f "leaf%g" 1 8 | xargs touch && mkdir level)
+        d=$d/level
+        i=$((i + 1))
+    done
+}
+
+for name in $LIST; do
+    dir=$FIXTURE_ROOT/$name
+    [ -f "$dir/.complete" ] && continue
+
+    case $name in
+        flat-10k)    gen="flat 10000" ;;
+        flat-100k)   gen="flat 100000" ;;
+        flat-1m)     gen="flat 1000000" ;;
+        prefix-100k) gen="prefix 100000" ;;
+        mixed-10k)   gen="mixed 10000" ;;
+        deep-256)    gen="deep 256" ;;
+        *) echo "Unknown fixture: $name" >&2; exit 1 ;;
+    esac
+
+    echo "Creating $dir ..."
+    rm -rf "$dir"
+    mkdir -p "$dir"
+    (cd "$dir" && $gen) || exit 1
+    touch "$dir/.complete"
+done
@@ -0,0 +1,89 @@
+/* ===========================================================
+ * meta_bench - synchronous statx vs io_uring IORING_OP_STATX
+ *
+ * Usage: meta_bench <directory> [rounds]
+ *
+ * Names are collected once; each round then clears the metadata and
+ * fetches it again for all of them with one backend (both skip
+ * entries that already have metadata).
+ * =========================================================== */
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "dirscan.h"
+#include "statpool.h"
+#include "uring.h"
+
+static void clear_meta(struct entry_table *t) {
+    for (int i = 0; i < t->count; i++)
+        memset(&t->items[i].meta, 0, sizeof(t->items[i].meta));
+}
+
+static double now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s <directory> [rounds]\n", argv[0]);
+        return 1;
+    }
+    int rounds = argc > 2 ? atoi(argv[2]) : 3;
+    if (rounds < 1) rounds = 1;
+
+    struct dirscan ds;
+    struct dirscan_entry e;
+    if (dirscan_open(&ds, argv[1], NULL, 0) == -1) {
+        perror("dirscan_open");
+        return 1;
+    }
+
+    struct entry_table table;
+    entry_table_init(&table);
+    while (dirscan_next(&ds, &e) == 1) {
+        if (e.name[0] == '.') continue;
+        if (!entry_table_add(&table, &e)) {
+            perror("malloc");
+            return 1;
+        }
+    }
+    int count = table.count;
+
+    double best_sync = 1e30, best_uring = 1e30;
+
+    for (int r = 0; r < rounds; r++) {
+        clear_meta(&table);
+        double t0 = now_ms();
+        meta_fetch_all(ds.fd, table.items, count, META_LONG, 1);
+        double t = now_ms() - t0;
+        if (t < best_sync) best_sync = t;
+    }
+
+    int have_uring = uring_available();
+    for (int r = 0; have_uring && r < rounds; r++) {
+        clear_meta(&table);
+        double t0 = now_ms();
+        if (meta_fetch_all_uring(ds.fd, table.items, count, META_LONG) == -1) {
+            have_uring = 0;
+            break;
+        }
+        double t = now_ms() - t0;
+        if (t < best_uring) best_uring = t;
+    }
+
+    printf("%-10s %10s %10s\n", "backend", "entries", "best ms");
+    printf("%-10s %10d %10.2f\n", "sync", count, best_sync);
+    if (have_uring)
+        printf("%-10s %10d %10.2f\n", "io_uring", count, best_uring);
+    else
+        printf("%-10s %10d %10s\n", "io_uring", count, "n/a");
+
+    entry_table_free(&table);
+    dirscan_close(&ds);
+    return 0;
+}
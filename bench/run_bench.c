@@ -0,0 +1,190 @@
+/* ===========================================================
+ * run_bench - measure one command for the benchmark suite
+ *
+ * Usage: run_bench <rounds> <program> [args...]
+ *
+ * Runs the command once to warm the page cache, then <rounds>
+ * times with stdout and stderr on /dev/null, and prints one CSV
+ * fragment with the median of each metric:
+ *
+ *   wall_ms,syscalls,maxrss_kb,minflt,majflt,status
+ *
+ * Syscalls are counted in one extra run under ptrace (all threads,
+ * so its own wall time is not used); the field is empty when
+ * ptrace is not permitted.
+ * =========================================================== */
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/ptrace.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+
+struct sample {
+    double wall_ms;
+    long maxrss_kb;
+    long minflt;
+    long majflt;
+    int status;
+};
+
+static double now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+static void quiet_exec(char **argv, int traced) {
+    int null = open("/dev/null", O_WRONLY);
+    if (null != -1) {
+        dup2(null, STDOUT_FILENO);
+        dup2(null, STDERR_FILENO);
+        close(null);
+    }
+    if (traced) {
+        ptrace(PTRACE_TRACEME, 0, NULL, NULL);
+        raise(SIGSTOP);
+    }
+    execv(argv[0], argv);
+    _exit(127);
+}
+
+static int run_once(char **argv, struct sample *s) {
+    double start = now_ms();
+    pid_t pid = fork();
+    if (pid == -1)
+        return -1;
+    if (pid == 0)
+        quiet_exec(argv, 0);
+
+    int status;
+    struct rusage ru;
+    if (wait4(pid, &status, 0, &ru) == -1)
+        return -1;
+    s->wall_ms = now_ms() - start;
+    s->maxrss_kb = ru.ru_maxrss;
+    s->minflt = ru.ru_minflt;
+    s->majflt = ru.ru_majflt;
+    s->status = WIFEXITED(status) ? WEXITSTATUS(status) : 128 + WTERMSIG(status);
+    return 0;
+}
+
+// Count syscall-entry stops of the command and every thread or child
+// it creates.  Each syscall stops twice (entry and exit) except the
+// final exit_group, hence the rounding.  Returns -1 if ptrace fails.
+static long count_syscalls(char **argv) {
+    pid_t pid = fork();
+    if (pid == -1)
+        return -1;
+    if (pid == 0)
+        quiet_exec(argv, 1);
+
+    int status;
+    if (waitpid(pid, &status, 0) == -1 || !WIFSTOPPED(status)) {
+        kill(pid, SIGKILL);
+        waitpid(pid, NULL, 0);
+        return -1;
+    }
+    long opts = PTRACE_O_TRACESYSGOOD | PTRACE_O_TRACECLONE | PTRACE_O_TRACEFORK |
+                PTRACE_O_TRACEVFORK | PTRACE_O_TRACEEXEC | PTRACE_O_EXITKILL;
+    if (ptrace(PTRACE_SETOPTIONS, pid, NULL, (void *)opts) == -1 ||
+        ptrace(PTRACE_SYSCALL, pid, NULL, NULL) == -1) {
+        kill(pid, SIGKILL);
+        waitpid(pid, NULL, 0);
+        return -1;
+    }
+
+    long stops = 0;
+    for (;;) {
+        pid_t tid = waitpid(-1, &status, __WALL);
+        if (tid == -1)
+            break;
+        if (!WIFSTOPPED(status))
+            continue;
+
+        int sig = WSTOPSIG(status);
+        if (sig == (SIGTRAP | 0x80)) {
+            stops++;
+            sig = 0;
+        } else if (sig == SIGTRAP && (status >> 16) != 0) {
+            sig = 0;                 // clone/fork/exec event
+        } else if (sig == SIGSTOP) {
+            sig = 0;                 // new threads start stopped
+        }
+        ptrace(PTRACE_SYSCALL, tid, NULL, (void *)(long)sig);
+    }
+    return (stops + 1) / 2;
+}
+
+static int cmp_double(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+static int cmp_long(const void *a, const void *b) {
+    long x = *(const long *)a, y = *(const long *)b;
+    return (x > y) - (x < y);
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 3) {
+        fprintf(stderr, "Usage: %s <rounds> <program> [args...]\n", argv[0]);
+        return 1;
+    }
+    int rounds = atoi(argv[1]);
+    if (rounds < 1) rounds = 1;
+    char **cmd = argv + 2;
+
+    struct sample s;
+    if (run_once(cmd, &s) == -1) {           // warm-up
+        perror("run");
+        return 1;
+    }
+
+    double *wall = malloc(rounds * sizeof(*wall));
+    long *rss = malloc(rounds * sizeof(*rss));
+    long *minflt = malloc(rounds * sizeof(*minflt));
+    long *majflt = malloc(rounds * sizeof(*majflt));
+    if (!wall || !rss || !minflt || !majflt) {
+        perror("malloc");
+        return 1;
+    }
+
+    int status = 0;
+    for (int i = 0; i < rounds; i++) {
+        if (run_once(cmd, &s) == -1) {
+            perror("run");
+            return 1;
+        }
+        wall[i] = s.wall_ms;
+        rss[i] = s.maxrss_kb;
+        minflt[i] = s.minflt;
+        majflt[i] = s.majflt;
+        if (s.status)
+            status = s.status;
+    }
+    qsort(wall, rounds, sizeof(*wall), cmp_double);
+    qsort(rss, rounds, sizeof(*rss), cmp_long);
+    qsort(minflt, rounds, sizeof(*minflt), cmp_long);
+    qsort(majflt, rounds, sizeof(*majflt), cmp_long);
+
+    long syscalls = count_syscalls(cmd);
+    int m = rounds / 2;
+
+    printf("%.2f,", wall[m]);
+    if (syscalls >= 0)
+        printf("%ld", syscalls);
+    printf(",%ld,%ld,%ld,%d\n", rss[m], minflt[m], majflt[m], status);
+
+    free(wall);
+    free(rss);
+    free(minflt);
+    free(majflt);
+    return 0;
+}
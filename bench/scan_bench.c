@@ -0,0 +1,91 @@
+/* ===========================================================
+ * scan_bench - readdir() vs dirscan (getdents64) enumeration
+ *
+ * Usage: scan_bench <directory> [rounds]
+ *
+ * readdir() is timed as-is.  glibc refills it with getdents64
+ * into a ~32 KiB buffer, so the dirscan run at 32 KiB shows the
+ * syscall count readdir pays; the larger sizes show the drop.
+ * =========================================================== */
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <dirent.h>
+#include <time.h>
+
+#include "dirscan.h"
+
+static double now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+static double bench_readdir(const char *path, long *entries) {
+    double t0 = now_ms();
+    DIR *dir = opendir(path);
+    if (!dir) {
+        perror("opendir");
+        exit(1);
+    }
+    long n = 0;
+    while (readdir(dir) != NULL)
+        n++;
+    closedir(dir);
+    *entries = n;
+    return now_ms() - t0;
+}
+
+static double bench_dirscan(const char *path, size_t bufsize, long *entries, unsigned long *calls) {
+    double t0 = now_ms();
+    struct dirscan ds;
+    struct dirscan_entry e;
+    if (dirscan_open(&ds, path, NULL, bufsize) == -1) {
+        perror("dirscan_open");
+        exit(1);
+    }
+    long n = 0;
+    while (dirscan_next(&ds, &e) == 1)
+        n++;
+    *calls = ds.calls;
+    dirscan_close(&ds);
+    *entries = n;
+    return now_ms() - t0;
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s <directory> [rounds]\n", argv[0]);
+        return 1;
+    }
+    const char *path = argv[1];
+    int rounds = argc > 2 ? atoi(argv[2]) : 5;
+    if (rounds < 1) rounds = 1;
+
+    static const size_t sizes[] = { 32 * 1024, 256 * 1024, 1024 * 1024 };
+    long entries;
+    unsigned long calls;
+
+    // Warm the dentry cache so every method sees the same state
+    bench_readdir(path, &entries);
+
+    double best = 1e30;
+    for (int r = 0; r < rounds; r++) {
+        double t = bench_readdir(path, &entries);
+        if (t < best) best = t;
+    }
+    printf("%-22s %10s %12s %10s\n", "method", "entries", "getdents64", "best ms");
+    printf("%-22s %10ld %12s %10.2f\n", "readdir", entries, "-", best);
+
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        best = 1e30;
+        for (int r = 0; r < rounds; r++) {
+            double t = bench_dirscan(path, sizes[i], &entries, &calls);
+            if (t < best) best = t;
+        }
+        char label[32];
+        snprintf(label, sizeof(label), "dirscan %zuK", sizes[i] / 1024);
+        printf("%-22s %10ld %12lu %10.2f\n", label, entries, calls, best);
+    }
+    return 0;
+}
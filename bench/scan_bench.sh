@@ -0,0 +1,18 @@
+#!/bin/sh
+# Build a directory with $ENTRIES empty files (1M by default) and
+# compare readdir() against dirscan on it.
+#
+# Usage: scan_bench.sh <scan_bench binary> [fixture dir]
+BENCH=$1
+FIXTURE=${2:-/tmp/lsv-bench-1m}
+ENTRIES=${ENTRIES:-1000000}
+
+if [ ! -f "$FIXTURE/.complete-$ENTRIES" ]; then
+    echo "Creating $ENTRIES entries in $FIXTURE ..."
+    rm -rf "$FIXTURE"
+    mkdir -p "$FIXTURE"
+    (cd "$FIXTURE" && seq -f "f%07g" 1 "$ENTRIES" | xargs touch)
+    touch "$FIXTURE/.complete-$ENTRIES"
+fi
+
+"$BENCH" "$FIXTURE" 5
@@ -0,0 +1,115 @@
+/* ===========================================================
+ * sort_bench - qsort(strcmp) vs the prefix-key radix engine
+ *
+ * Usage: sort_bench [entries]
+ *
+ * Two synthetic name sets: random 8-24 character names, and long
+ * shared-prefix names like "build-000001.o" in shuffled order.
+ * Each method sorts a fresh copy; the results are cross-checked.
+ * The collate column uses strxfrm keys for the LC_COLLATE taken
+ * from the environment (e.g. LC_ALL=en_US.UTF-8 sort_bench).
+ * =========================================================== */
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <locale.h>
+
+#include "sort.h"
+
+static double now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+static void add_name(struct entry_table *t, const char *name) {
+    struct dirscan_entry de = { .ino = 0, .type = 0, .namelen = strlen(name), .name = name };
+    if (!entry_table_add(t, &de)) {
+        perror("malloc");
+        exit(1);
+    }
+}
+
+static void make_random(struct entry_table *t, int n) {
+    static const char alphabet[] = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789_-.";
+    char name[32];
+    for (int i = 0; i < n; i++) {
+        int len = 8 + rand() % 17;
+        for (int k = 0; k < len; k++)
+            name[k] = alphabet[rand() % (sizeof(alphabet) - 1)];
+        name[len] = '\0';
+        add_name(t, name);
+    }
+}
+
+static void make_shared_prefix(struct entry_table *t, int n) {
+    char name[64];
+    for (int i = 0; i < n; i++) {
+        snprintf(name, sizeof(name), "build-%06d.o", i);
+        add_name(t, name);
+    }
+    // Shuffle so the input is not already sorted
+    for (int i = n - 1; i > 0; i--) {
+        int j = rand() % (i + 1);
+        struct entry tmp = t->items[i];
+        t->items[i] = t->items[j];
+        t->items[j] = tmp;
+    }
+}
+
+static void run(const char *label, struct entry_table *t) {
+    size_t bytes = t->count * sizeof(struct entry);
+    struct entry *a = malloc(bytes), *b = malloc(bytes), *c = malloc(bytes);
+    memcpy(a, t->items, bytes);
+    memcpy(b, t->items, bytes);
+    memcpy(c, t->items, bytes);
+
+    double t0 = now_ms();
+    qsort(a, t->count, sizeof(struct entry), compare_names);
+    double t_qsort = now_ms() - t0;
+
+    t0 = now_ms();
+    sort_entries_by_name(b, t->count);
+    double t_radix = now_ms() - t0;
+
+    t0 = now_ms();
+    sort_entries_by_collation(c, t->count);
+    double t_collate = now_ms() - t0;
+
+    int ok = 1;
+    for (int i = 0; i < t->count; i++)
+        if (a[i].name != b[i].name) ok = 0;
+
+    // The collated order must agree with the merge comparator
+    for (int i = 1; i < t->count; i++)
+        if (compare_collated(&c[i - 1], &c[i]) > 0) ok = 0;
+
+    printf("%-16s %9d %12.2f %12.2f %12.2f %8s\n", label, t->count,
+           t_qsort, t_radix, t_collate, ok ? "ok" : "MISMATCH");
+    free(a);
+    free(b);
+    free(c);
+}
+
+int main(int argc, char *argv[]) {
+    int n = argc > 1 ? atoi(argv[1]) : 1000000;
+    struct entry_table t;
+
+    setlocale(LC_CTYPE, "");
+    setlocale(LC_COLLATE, "");
+    srand(42);
+    printf("%-16s %9s %12s %12s %12s %8s\n", "names", "entries", "qsort ms", "radix ms", "collate ms", "check");
+
+    entry_table_init(&t);
+    make_random(&t, n);
+    run("random", &t);
+    entry_table_free(&t);
+
+    entry_table_init(&t);
+    make_shared_prefix(&t, n);
+    run("shared-prefix", &t);
+    entry_table_free(&t);
+    return 0;
+}
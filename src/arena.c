@@ -0,0 +1,64 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "arena.h"
+
+struct arena_chunk {
+    struct arena_chunk *next;
+    size_t size;
+    size_t used;
+    char data[];
+};
+
+void arena_init(struct arena *a) {
+    a->head = NULL;
+    a->next_size = ARENA_MIN_CHUNK;
+    a->chunks = 0;
+    a->bytes = 0;
+}
+
+void *arena_alloc(struct arena *a, size_t n) {
+    struct arena_chunk *c = a->head;
+
+    if (!c || c->size - c->used < n) {
+        size_t size = a->next_size;
+        while (size < n)
+            size *= 2;
+
+        c = malloc(sizeof(*c) + size);
+        if (!c)
+            return NULL;
+        c->next = a->head;
+        c->size = size;
+        c->used = 0;
+        a->head = c;
+        a->chunks++;
+
+        if (a->next_size < ARENA_MAX_CHUNK)
+            a->next_size *= 2;
+    }
+
+    void *p = c->data + c->used;
+    c->used += n;
+    a->bytes += n;
+    return p;
+}
+
+char *arena_strndup(struct arena *a, const char *s, size_t n) {
+    char *p = arena_alloc(a, n + 1);
+    if (!p)
+        return NULL;
+    memcpy(p, s, n);
+    p[n] = '\0';
+    return p;
+}
+
+void arena_free(struct arena *a) {
+    struct arena_chunk *c = a->head;
+    while (c) {
+        struct arena_chunk *next = c->next;
+        free(c);
+        c = next;
+    }
+    arena_init(a);
+}
@@ -0,0 +1,35 @@
+/* ===========================================================
+ * arena.h - Chunked bump allocator for entry names
+ *
+ * Names are packed back to back into large chunks instead of one
+ * malloc() per entry.  Chunk sizes grow geometrically, pointers
+ * into a chunk never move, and arena_free() releases everything.
+ * =========================================================== */
+#ifndef LSV_ARENA_H
+#define LSV_ARENA_H
+
+#include <stddef.h>
+
+#define ARENA_MIN_CHUNK (64 * 1024)
+#define ARENA_MAX_CHUNK (4 * 1024 * 1024)
+
+struct arena_chunk;
+
+struct arena {
+    struct arena_chunk *head;    // chunk currently being filled
+    size_t next_size;            // size of the next chunk to allocate
+    unsigned long chunks;        // chunks allocated so far
+    size_t bytes;                // bytes handed out so far
+};
+
+void arena_init(struct arena *a);
+
+// Allocate n bytes (no alignment guarantee).  NULL on failure.
+void *arena_alloc(struct arena *a, size_t n);
+
+// Copy n bytes of s plus a terminating NUL into the arena
+char *arena_strndup(struct arena *a, const char *s, size_t n);
+
+void arena_free(struct arena *a);
+
+#endif
@@ -0,0 +1,289 @@
+#define _GNU_SOURCE
+#include <stdlib.h>
+#include <string.h>
+#include <dirent.h>
+#include <stdint.h>
+#include <sys/stat.h>
+
+#include "arena.h"
+#include "colors.h"
+
+// Classic lsv colors, in LS_COLORS syntax
+#define DEFAULT_LINK_COLOR "1;35"
+static const char default_colors[] =
+    "rs=0:fi=0:di=0;34:ln=" DEFAULT_LINK_COLOR ":pi=7:so=7:bd=7:cd=7:ex=0;32:"
+    "*.tar=0;31:*.gz=0;31:*.zip=0;31";
+
+enum color_kind {
+    CK_RESET, CK_FILE, CK_DIR, CK_LINK, CK_FIFO, CK_SOCK, CK_BLK, CK_CHR,
+    CK_EXEC, CK_SETUID, CK_SETGID, CK_STICKY, CK_OTHER_WRITABLE,
+    CK_STICKY_OTHER_WRITABLE, CK_COUNT
+};
+
+static const char *const kind_keys[CK_COUNT] = {
+    "rs", "fi", "di", "ln", "pi", "so", "bd", "cd",
+    "ex", "su", "sg", "st", "ow", "tw",
+};
+
+// "*.ext" patterns, keyed case-insensitively by ext
+struct ext_slot {
+    const char *ext;         // NULL for an empty slot
+    size_t len;
+    struct color_seq color;
+};
+
+// Other "*suffix" patterns (several dots, or no dot at all); rare,
+// so they are checked one by one before the hash
+struct suffix_rule {
+    const char *suffix;
+    size_t len;
+    struct color_seq color;
+};
+
+struct color_table {
+    struct color_seq kinds[CK_COUNT];    // len 0 when not set
+    struct ext_slot *exts;
+    unsigned int ext_capacity;           // power of two, or 0
+    struct suffix_rule *suffixes;
+    int nsuffixes;
+    int use_mode;                        // stat plain listings for ex su sg st ow tw
+    struct arena strings;
+};
+
+static struct color_table colors;
+
+static unsigned char lower(unsigned char c) {
+    return (c >= 'A' && c <= 'Z') ? c + ('a' - 'A') : c;
+}
+
+static uint32_t ext_hash(const char *s, size_t len) {
+    uint32_t h = 2166136261u;                    // FNV-1a
+    for (size_t i = 0; i < len; i++)
+        h = (h ^ lower((unsigned char)s[i])) * 16777619u;
+    return h;
+}
+
+static int same_ci(const char *a, const char *b, size_t len) {
+    for (size_t i = 0; i < len; i++)
+        if (lower((unsigned char)a[i]) != lower((unsigned char)b[i]))
+            return 0;
+    return 1;
+}
+
+static int make_seq(struct arena *a, const char *code, struct color_seq *out) {
+    size_t n = strlen(code);
+    char *seq = arena_alloc(a, n + 4);
+    if (!seq)
+        return -1;
+    seq[0] = '\033';
+    seq[1] = '[';
+    memcpy(seq + 2, code, n);
+    seq[n + 2] = 'm';
+    seq[n + 3] = '\0';
+    out->seq = seq;
+    out->len = n + 3;
+    return 0;
+}
+
+// A later pattern for the same extension replaces the earlier one
+static void ext_insert(struct color_table *t, const char *ext, size_t len, struct color_seq color) {
+    unsigned int mask = t->ext_capacity - 1;
+    for (unsigned int i = ext_hash(ext, len) & mask;; i = (i + 1) & mask) {
+        struct ext_slot *s = &t->exts[i];
+        if (!s->ext || (s->len == len && same_ci(s->ext, ext, len))) {
+            s->ext = ext;
+            s->len = len;
+            s->color = color;
+            return;
+        }
+    }
+}
+
+static int parse(struct color_table *t, const char *spec) {
+    memset(t, 0, sizeof(*t));
+    arena_init(&t->strings);
+
+    size_t speclen = strlen(spec);
+    char *buf = arena_strndup(&t->strings, spec, speclen);
+    if (!buf)
+        return -1;
+
+    // Size the tables for the worst case: every field a pattern
+    int fields = 1;
+    for (size_t i = 0; i < speclen; i++)
+        fields += spec[i] == ':';
+    t->ext_capacity = 16;
+    while (t->ext_capacity < 2u * fields)
+        t->ext_capacity *= 2;
+    t->exts = calloc(t->ext_capacity, sizeof(*t->exts));
+    t->suffixes = malloc(fields * sizeof(*t->suffixes));
+    if (!t->exts || !t->suffixes)
+        return -1;
+
+    for (char *field = buf, *next; field; field = next) {
+        next = strchr(field, ':');
+        if (next)
+            *next++ = '\0';
+        char *eq = strchr(field, '=');
+        if (!eq || eq == field)
+            continue;
+        *eq = '\0';
+        const char *code = eq + 1;
+
+        // "ln=target" asks for links in their target's color, which
+        // would cost a stat of every target; they keep the lsv link
+        // color instead
+        if (strcmp(field, "ln") == 0 && strcmp(code, "target") == 0)
+            code = DEFAULT_LINK_COLOR;
+
+        // An empty code leaves the key unset (and undoes an earlier one)
+        struct color_seq color = { NULL, 0 };
+        if (*code && make_seq(&t->strings, code, &color) == -1)
+            return -1;
+
+        if (field[0] == '*') {
+            if (!color.len)
+                continue;
+            const char *pat = field + 1;
+            size_t len = strlen(pat);
+            if (len > 1 && pat[0] == '.' && !memchr(pat + 1, '.', len - 1)) {
+                ext_insert(t, pat + 1, len - 1, color);
+            } else if (len > 0) {
+                struct suffix_rule *r = &t->suffixes[t->nsuffixes++];
+                r->suffix = pat;
+                r->len = len;
+                r->color = color;
+            }
+            continue;
+        }
+        for (int k = 0; k < CK_COUNT; k++) {
+            if (strcmp(field, kind_keys[k]) == 0) {
+                t->kinds[k] = color;
+                break;
+            }
+        }
+    }
+
+    // Unset codes fall back to fi, and fi to a plain reset
+    if (!t->kinds[CK_RESET].len && make_seq(&t->strings, "0", &t->kinds[CK_RESET]) == -1)
+        return -1;
+    if (!t->kinds[CK_FILE].len)
+        t->kinds[CK_FILE] = t->kinds[CK_RESET];
+    return 0;
+}
+
+static void release(struct color_table *t) {
+    free(t->exts);
+    free(t->suffixes);
+    arena_free(&t->strings);
+}
+
+int colors_init(const char *spec, int use_mode) {
+    struct color_table t;
+
+    if (!spec || !*spec)
+        spec = default_colors;
+    int rc = parse(&t, spec);
+    if (rc == -1 && spec != default_colors) {
+        release(&t);
+        if (parse(&t, default_colors) == -1) {
+            release(&t);
+            return -1;
+        }
+    } else if (rc == -1) {
+        release(&t);
+        return -1;
+    }
+    t.use_mode = use_mode;
+    release(&colors);
+    colors = t;
+    return rc;
+}
+
+static const struct color_seq *kind(enum color_kind k) {
+    return colors.kinds[k].len ? &colors.kinds[k] : &colors.kinds[CK_FILE];
+}
+
+static const struct color_seq *by_name(const char *name, size_t len) {
+    for (int i = 0; i < colors.nsuffixes; i++) {
+        const struct suffix_rule *r = &colors.suffixes[i];
+        if (r->len <= len && same_ci(name + len - r->len, r->suffix, r->len))
+            return &r->color;
+    }
+
+    if (!colors.ext_capacity)
+        return NULL;
+    const char *dot = name + len;
+    while (dot > name && dot[-1] != '.')
+        dot--;
+    if (dot == name || dot == name + len)
+        return NULL;
+
+    size_t extlen = name + len - dot;
+    unsigned int mask = colors.ext_capacity - 1;
+    for (unsigned int i = ext_hash(dot, extlen) & mask;; i = (i + 1) & mask) {
+        const struct ext_slot *s = &colors.exts[i];
+        if (!s->ext)
+            return NULL;
+        if (s->len == extlen && same_ci(s->ext, dot, extlen))
+            return &s->color;
+    }
+}
+
+const struct color_seq *color_of(const struct entry *e) {
+    mode_t mode = e->meta.mode;
+    // Permission bits are only there when the mode came from a stat,
+    // not from d_type alone
+    int have_perms = (e->meta.valid & META_MODE) != 0;
+
+    if (e->meta.error)
+        return kind(CK_FILE);
+    if (S_ISDIR(mode)) {
+        if (!have_perms)
+            return kind(CK_DIR);
+        if ((mode & S_ISVTX) && (mode & S_IWOTH) && colors.kinds[CK_STICKY_OTHER_WRITABLE].len)
+            return &colors.kinds[CK_STICKY_OTHER_WRITABLE];
+        if ((mode & S_IWOTH) && colors.kinds[CK_OTHER_WRITABLE].len)
+            return &colors.kinds[CK_OTHER_WRITABLE];
+        if ((mode & S_ISVTX) && colors.kinds[CK_STICKY].len)
+            return &colors.kinds[CK_STICKY];
+        return kind(CK_DIR);
+    }
+    if (S_ISLNK(mode))
+        return kind(CK_LINK);
+    if (S_ISFIFO(mode))
+        return kind(CK_FIFO);
+    if (S_ISSOCK(mode))
+        return kind(CK_SOCK);
+    if (S_ISBLK(mode))
+        return kind(CK_BLK);
+    if (S_ISCHR(mode))
+        return kind(CK_CHR);
+
+    if (have_perms) {
+        if ((mode & S_ISUID) && colors.kinds[CK_SETUID].len)
+            return &colors.kinds[CK_SETUID];
+        if ((mode & S_ISGID) && colors.kinds[CK_SETGID].len)
+            return &colors.kinds[CK_SETGID];
+        if ((mode & S_IXUSR) && colors.kinds[CK_EXEC].len)
+            return &colors.kinds[CK_EXEC];
+    }
+
+    const struct color_seq *c = by_name(e->name, e->namelen);
+    return c ? c : kind(CK_FILE);
+}
+
+int colors_need_mode(unsigned char d_type) {
+    const struct color_seq *k = colors.kinds;
+    if (!colors.use_mode)
+        return d_type == DT_UNKNOWN;
+    if (d_type == DT_REG)
+        return k[CK_EXEC].len || k[CK_SETUID].len || k[CK_SETGID].len;
+    if (d_type == DT_DIR)
+        return k[CK_STICKY].len || k[CK_OTHER_WRITABLE].len || k[CK_STICKY_OTHER_WRITABLE].len;
+    return d_type == DT_UNKNOWN;
+}
+
+const struct color_seq *color_reset(void) {
+    return &colors.kinds[CK_RESET];
+}
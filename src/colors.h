@@ -0,0 +1,50 @@
+/* ===========================================================
+ * colors.h - LS_COLORS color engine
+ *
+ * LS_COLORS is parsed once at startup.  File type codes (di, ln,
+ * ex, ...) index a small array and "*.ext" patterns go into an
+ * open-addressing hash keyed by the text after the last dot, so
+ * picking a color is one reverse scan for the dot and one probe.
+ * Every code is stored as its finished escape sequence.
+ *
+ * Without LS_COLORS the built-in palette matches the classic lsv
+ * colors (directories blue, executables green, links pink, .tar,
+ * .gz and .zip red, special files reversed).
+ *
+ * The permission-based codes (ex su sg st ow tw) apply whenever an
+ * entry's mode came from a stat, as it always does for -l.  Plain
+ * listings color from d_type alone unless asked to stat every file
+ * and directory for them (use_mode).
+ * =========================================================== */
+#ifndef LSV_COLORS_H
+#define LSV_COLORS_H
+
+#include <stddef.h>
+
+#include "entry.h"
+
+struct color_seq {
+    const char *seq;         // "\033[<code>m"
+    size_t len;
+};
+
+// Parse spec (LS_COLORS syntax), or the built-in palette when spec
+// is NULL or empty.  Unknown keys are ignored, empty codes leave a
+// key unset and "ln=target" keeps the built-in link color.  Returns
+// 0, or -1 on allocation failure (the built-in palette is then kept).
+// use_mode makes colors_need_mode() ask for a stat wherever the
+// permission-based codes could apply.
+int colors_init(const char *spec, int use_mode);
+
+// Sequence to print before e's name.  Thread-safe after colors_init().
+const struct color_seq *color_of(const struct entry *e);
+
+// Non-zero if the dirent type alone cannot pick the color: DT_UNKNOWN,
+// or with use_mode a file or directory whose permission bits matter
+// (ex, su, sg for files; st, ow, tw for directories)
+int colors_need_mode(unsigned char d_type);
+
+// Sequence that ends a colored name
+const struct color_seq *color_reset(void);
+
+#endif
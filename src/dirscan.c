@@ -0,0 +1,101 @@
+#define _GNU_SOURCE
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <stdint.h>
+#include <sys/syscall.h>
+
+#include "dirscan.h"
+#include "stats.h"
+
+// Layout of the records returned by getdents64(2)
+struct linux_dirent64 {
+    uint64_t d_ino;
+    int64_t d_off;
+    unsigned short d_reclen;
+    unsigned char d_type;
+    char d_name[];
+};
+
+static int dirscan_init(struct dirscan *ds, int fd, int own_fd, char *buf, size_t bufsize) {
+    memset(ds, 0, sizeof(*ds));
+    if (bufsize == 0)
+        bufsize = DIRSCAN_DEFAULT_BUFSIZE;
+
+    ds->fd = fd;
+    ds->own_fd = own_fd;
+    ds->bufsize = bufsize;
+    ds->buf = buf;
+    if (!ds->buf) {
+        ds->buf = malloc(bufsize);
+        if (!ds->buf)
+            return -1;
+        ds->own_buf = 1;
+    }
+    return 0;
+}
+
+int dirscan_open(struct dirscan *ds, const char *path, char *buf, size_t bufsize) {
+    int fd = open(path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd == -1)
+        return -1;
+
+    if (dirscan_init(ds, fd, 1, buf, bufsize) == -1) {
+        int saved = errno;
+        close(fd);
+        errno = saved;
+        return -1;
+    }
+    return 0;
+}
+
+int dirscan_fdopen(struct dirscan *ds, int fd, char *buf, size_t bufsize) {
+    return dirscan_init(ds, fd, 0, buf, bufsize);
+}
+
+int dirscan_next(struct dirscan *ds, struct dirscan_entry *out) {
+    while (ds->pos >= ds->len) {
+        if (ds->eof)
+            return 0;
+
+        long n = syscall(SYS_getdents64, ds->fd, ds->buf, ds->bufsize);
+        ds->calls++;
+        stats_add(STATS_GETDENTS, 1);
+        if (n < 0)
+            return -1;
+        if (n == 0) {
+            ds->eof = 1;
+            return 0;
+        }
+        ds->pos = 0;
+        ds->len = (size_t)n;
+    }
+
+    struct linux_dirent64 *d = (struct linux_dirent64 *)(ds->buf + ds->pos);
+    ds->pos += d->d_reclen;
+
+    out->ino = (ino_t)d->d_ino;
+    out->type = d->d_type;
+    out->name = d->d_name;
+    out->namelen = strlen(d->d_name);
+    return 1;
+}
+
+int dirscan_rewind(struct dirscan *ds) {
+    if (lseek(ds->fd, 0, SEEK_SET) == -1)
+        return -1;
+    ds->pos = ds->len = 0;
+    ds->eof = 0;
+    return 0;
+}
+
+void dirscan_close(struct dirscan *ds) {
+    if (ds->own_fd && ds->fd >= 0)
+        close(ds->fd);
+    if (ds->own_buf)
+        free(ds->buf);
+    ds->fd = -1;
+    ds->buf = NULL;
+}
@@ -0,0 +1,52 @@
+/* ===========================================================
+ * dirscan.h - Batched directory reader built on getdents64
+ *
+ * readdir() hands back one entry per call and refills its
+ * internal buffer in small chunks.  dirscan reads whole batches
+ * of raw dirents into a caller-sized buffer (256 KiB by default)
+ * and walks them in user space, keeping d_ino and d_type.
+ * =========================================================== */
+#ifndef LSV_DIRSCAN_H
+#define LSV_DIRSCAN_H
+
+#include <stddef.h>
+#include <sys/types.h>
+
+#define DIRSCAN_DEFAULT_BUFSIZE (256 * 1024)
+
+struct dirscan_entry {
+    ino_t ino;
+    unsigned char type;      // DT_* value, may be DT_UNKNOWN
+    size_t namelen;
+    const char *name;        // valid until the next dirscan_next()
+};
+
+struct dirscan {
+    int fd;                  // open directory, usable with *at() calls
+    int own_fd;              // close fd in dirscan_close()
+    char *buf;
+    size_t bufsize;
+    int own_buf;             // free buf in dirscan_close()
+    size_t pos, len;
+    int eof;
+    unsigned long calls;     // getdents64 syscalls issued so far
+};
+
+// Open a directory by path.  If buf is NULL a buffer of bufsize
+// bytes (or the default when bufsize is 0) is allocated.
+int dirscan_open(struct dirscan *ds, const char *path, char *buf, size_t bufsize);
+
+// Same as dirscan_open() but on an already open directory fd.
+// The fd is not closed by dirscan_close().
+int dirscan_fdopen(struct dirscan *ds, int fd, char *buf, size_t bufsize);
+
+// Fetch the next entry.  Returns 1 on success, 0 at end of
+// directory and -1 on error (errno is set).
+int dirscan_next(struct dirscan *ds, struct dirscan_entry *out);
+
+// Restart the scan from the first entry.
+int dirscan_rewind(struct dirscan *ds);
+
+void dirscan_close(struct dirscan *ds);
+
+#endif
@@ -0,0 +1,49 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "entry.h"
+
+void entry_table_init(struct entry_table *t) {
+    t->items = NULL;
+    t->count = 0;
+    t->capacity = 0;
+    arena_init(&t->names);
+}
+
+struct entry *entry_table_add(struct entry_table *t, const struct dirscan_entry *de) {
+    if (t->count >= t->capacity) {
+        int capacity = t->capacity ? t->capacity * 2 : 64;
+        struct entry *items = realloc(t->items, capacity * sizeof(*items));
+        if (!items)
+            return NULL;
+        t->items = items;
+        t->capacity = capacity;
+    }
+
+    const char *name = arena_strndup(&t->names, de->name, de->namelen);
+    if (!name)
+        return NULL;
+
+    struct entry *e = &t->items[t->count++];
+    memset(e, 0, sizeof(*e));
+    e->name = name;
+    e->namelen = (uint16_t)de->namelen;
+    e->ino = de->ino;
+    e->d_type = de->type;
+    return e;
+}
+
+size_t entry_table_bytes(const struct entry_table *t) {
+    return (size_t)t->count * sizeof(struct entry) + t->names.bytes;
+}
+
+void entry_table_clear(struct entry_table *t) {
+    arena_free(&t->names);
+    t->count = 0;
+}
+
+void entry_table_free(struct entry_table *t) {
+    arena_free(&t->names);
+    free(t->items);
+    entry_table_init(t);
+}
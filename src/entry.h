@@ -0,0 +1,51 @@
+/* ===========================================================
+ * entry.h - One record per directory entry
+ *
+ * Everything the listing needs about an entry (name, d_ino, d_type
+ * and its metadata) is gathered once during the scan phase.
+ * Sorting, coloring and every display mode read from this record
+ * and never go back to the filesystem.
+ * =========================================================== */
+#ifndef LSV_ENTRY_H
+#define LSV_ENTRY_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+#include "arena.h"
+#include "dirscan.h"
+#include "meta.h"
+
+struct entry {
+    const char *name;        // points into the table's name arena
+    uint16_t namelen;        // dirent names are at most 255 bytes
+    unsigned char d_type;    // DT_* from the dirent
+    ino_t ino;               // from the dirent
+    struct file_meta meta;   // filled by meta_fetch_all()
+};
+
+// Entries grow geometrically in one array; their names live in a
+// chunked arena, so the whole table costs a handful of allocations
+// and entry_table_free() releases it in one call.
+struct entry_table {
+    struct entry *items;
+    int count;
+    int capacity;
+    struct arena names;
+};
+
+void entry_table_init(struct entry_table *t);
+
+// Append a copy of a scanned dirent.  Returns NULL on allocation failure.
+struct entry *entry_table_add(struct entry_table *t, const struct dirscan_entry *de);
+
+// Memory used by the entries held (index slots in use plus names)
+size_t entry_table_bytes(const struct entry_table *t);
+
+// Drop all entries but keep the index allocation for reuse
+void entry_table_clear(struct entry_table *t);
+
+void entry_table_free(struct entry_table *t);
+
+#endif
@@ -0,0 +1,142 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "entryset.h"
+
+#define SLOT_EMPTY   (-1)
+#define SLOT_REMOVED (-2)
+
+// Holes tolerated before entry_set_compact() rebuilds the table
+#define COMPACT_MIN_HOLES 1024
+
+static uint32_t name_hash(const char *s, size_t len) {
+    uint32_t h = 2166136261u;                    // FNV-1a
+    for (size_t i = 0; i < len; i++)
+        h = (h ^ (unsigned char)s[i]) * 16777619u;
+    return h;
+}
+
+static int *slot_for(struct entry_set *s, const char *name, size_t namelen, int want_free) {
+    unsigned int mask = s->capacity - 1;
+    int *first_removed = NULL;
+
+    for (unsigned int i = name_hash(name, namelen) & mask;; i = (i + 1) & mask) {
+        int *slot = &s->slots[i];
+        if (*slot == SLOT_EMPTY)
+            return want_free && first_removed ? first_removed : slot;
+        if (*slot == SLOT_REMOVED) {
+            if (!first_removed)
+                first_removed = slot;
+            continue;
+        }
+        const struct entry *e = &s->table.items[*slot];
+        if (e->namelen == namelen && memcmp(e->name, name, namelen) == 0)
+            return slot;
+    }
+}
+
+// Size the hash for the table's entries (load factor <= 1/2) and
+// index every live one
+static int rehash(struct entry_set *s) {
+    unsigned int capacity = 64;
+    while (capacity < 2u * (unsigned int)s->table.count + 2)
+        capacity *= 2;
+    int *slots = malloc(capacity * sizeof(*slots));
+    if (!slots)
+        return -1;
+    for (unsigned int i = 0; i < capacity; i++)
+        slots[i] = SLOT_EMPTY;
+
+    free(s->slots);
+    s->slots = slots;
+    s->capacity = capacity;
+    s->live = 0;
+    for (int i = 0; i < s->table.count; i++) {
+        const struct entry *e = &s->table.items[i];
+        if (!e->name)
+            continue;
+        *slot_for(s, e->name, e->namelen, 1) = i;
+        s->live++;
+    }
+    return 0;
+}
+
+int entry_set_init(struct entry_set *s, struct entry_table *t) {
+    s->table = *t;
+    entry_table_init(t);
+    s->slots = NULL;
+    s->capacity = 0;
+    s->live = 0;
+    return rehash(s);
+}
+
+struct entry *entry_set_find(struct entry_set *s, const char *name, size_t namelen) {
+    int *slot = slot_for(s, name, namelen, 0);
+    return *slot >= 0 ? &s->table.items[*slot] : NULL;
+}
+
+struct entry *entry_set_add(struct entry_set *s, const struct dirscan_entry *de,
+                            const struct file_meta *meta) {
+    // Keep the hash at most half full, holes included
+    if (2u * ((unsigned int)s->table.count + 1) > s->capacity) {
+        struct entry *e = entry_table_add(&s->table, de);
+        if (!e || rehash(s) == -1)
+            return NULL;
+        e = &s->table.items[s->table.count - 1];
+        e->meta = *meta;
+        return e;
+    }
+
+    struct entry *e = entry_table_add(&s->table, de);
+    if (!e)
+        return NULL;
+    e->meta = *meta;
+    *slot_for(s, e->name, e->namelen, 1) = s->table.count - 1;
+    s->live++;
+    return e;
+}
+
+void entry_set_remove(struct entry_set *s, struct entry *e) {
+    int *slot = slot_for(s, e->name, e->namelen, 0);
+    if (*slot < 0)
+        return;
+    *slot = SLOT_REMOVED;
+    e->name = NULL;
+    s->live--;
+}
+
+int entry_set_compact(struct entry_set *s) {
+    int holes = s->table.count - s->live;
+    if (holes < COMPACT_MIN_HOLES || holes <= s->live)
+        return 0;
+
+    struct entry_table fresh;
+    entry_table_init(&fresh);
+    for (int i = 0; i < s->table.count; i++) {
+        const struct entry *old = &s->table.items[i];
+        if (!old->name)
+            continue;
+        struct dirscan_entry de = {
+            .ino = old->ino, .type = old->d_type,
+            .namelen = old->namelen, .name = old->name,
+        };
+        struct entry *e = entry_table_add(&fresh, &de);
+        if (!e) {
+            entry_table_free(&fresh);
+            return -1;
+        }
+        e->meta = old->meta;
+    }
+    entry_table_free(&s->table);
+    s->table = fresh;
+    return rehash(s);
+}
+
+void entry_set_free(struct entry_set *s) {
+    entry_table_free(&s->table);
+    free(s->slots);
+    s->slots = NULL;
+    s->capacity = 0;
+    s->live = 0;
+}
@@ -0,0 +1,45 @@
+/* ===========================================================
+ * entryset.h - Entry table indexed by name (--watch)
+ *
+ * Keeps a directory's entries in an entry_table with an open-
+ * addressing hash from name to table index, so a single create,
+ * delete or attribute event costs one probe regardless of how many
+ * entries the directory holds.  Removed entries leave holes that
+ * are compacted away once they outnumber the live ones.
+ * =========================================================== */
+#ifndef LSV_ENTRYSET_H
+#define LSV_ENTRYSET_H
+
+#include <stddef.h>
+
+#include "entry.h"
+
+struct entry_set {
+    struct entry_table table;    // holes have name == NULL
+    int *slots;                  // table index, or -1 (empty) / -2 (removed)
+    unsigned int capacity;       // power of two
+    int live;
+};
+
+// Take over the entries of t (t is left empty).  Returns 0 or -1.
+int entry_set_init(struct entry_set *s, struct entry_table *t);
+
+// NULL if name is not in the set
+struct entry *entry_set_find(struct entry_set *s, const char *name, size_t namelen);
+
+// Insert a copy of de (not already present) with meta.  The returned
+// pointer, like every other entry pointer, stays valid only until
+// the next entry_set_add() or entry_set_compact().  NULL on failure.
+struct entry *entry_set_add(struct entry_set *s, const struct dirscan_entry *de,
+                            const struct file_meta *meta);
+
+// Remove e.  A copy of *e taken beforehand keeps a readable name
+// until entry_set_compact().
+void entry_set_remove(struct entry_set *s, struct entry *e);
+
+// Drop the holes if they outnumber the live entries
+int entry_set_compact(struct entry_set *s);
+
+void entry_set_free(struct entry_set *s);
+
+#endif
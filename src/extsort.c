@@ -0,0 +1,231 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+
+#include "extsort.h"
+
+// Per-run stdio buffer used while spilling and merging
+#define EXTSORT_IOBUF (64 * 1024)
+
+// A run record is the raw struct entry (its name pointer is
+// meaningless on disk) followed by namelen bytes of name.
+struct run_cursor {
+    FILE *fp;
+    struct entry e;
+    char name[256];
+};
+
+void extsort_init(struct extsort *xs, entry_cmp_fn cmp, const void *ctx) {
+    xs->runs = NULL;
+    xs->levels = NULL;
+    xs->nruns = 0;
+    xs->capacity = 0;
+    xs->cmp = cmp;
+    xs->ctx = ctx;
+}
+
+// tmpfile() always uses /tmp, which in containers is often a tmpfs
+// charged to the same memory limit the spill is meant to respect
+static FILE *run_create(void) {
+    const char *dir = getenv("TMPDIR");
+    if (!dir || !*dir)
+        dir = "/tmp";
+
+    char *path = malloc(strlen(dir) + sizeof("/lsv-run-XXXXXX"));
+    if (!path)
+        return NULL;
+    sprintf(path, "%s/lsv-run-XXXXXX", dir);
+
+    FILE *fp = NULL;
+    int fd = mkstemp(path);
+    if (fd != -1) {
+        unlink(path);
+        fp = fdopen(fd, "w+");
+        if (!fp)
+            close(fd);
+    }
+    free(path);
+
+    if (fp)
+        setvbuf(fp, NULL, _IOFBF, EXTSORT_IOBUF);
+    return fp;
+}
+
+static int run_write(const struct entry *e, FILE *fp) {
+    if (fwrite(e, sizeof(struct entry), 1, fp) != 1 ||
+        fwrite(e->name, 1, e->namelen, fp) != e->namelen)
+        return -1;
+    return 0;
+}
+
+static int run_rewind(FILE *fp) {
+    if (fflush(fp) == EOF || fseek(fp, 0, SEEK_SET) == -1)
+        return -1;
+    return 0;
+}
+
+// Load the next record of a run; returns 1, 0 at end of run, -1 on error
+static int cursor_next(struct run_cursor *c) {
+    if (fread(&c->e, sizeof(struct entry), 1, c->fp) != 1)
+        return ferror(c->fp) ? -1 : 0;
+    if (c->e.namelen >= sizeof(c->name) ||
+        fread(c->name, 1, c->e.namelen, c->fp) != c->e.namelen) {
+        errno = EIO;
+        return -1;
+    }
+    c->name[c->e.namelen] = '\0';
+    c->e.name = c->name;
+    return 1;
+}
+
+// Min-heap of cursors ordered by their current entry
+static void heap_sift_down(struct run_cursor **heap, int n, int i, const struct extsort *xs) {
+    for (;;) {
+        int l = 2 * i + 1, r = l + 1, m = i;
+        if (l < n && xs->cmp(&heap[l]->e, &heap[m]->e, xs->ctx) < 0) m = l;
+        if (r < n && xs->cmp(&heap[r]->e, &heap[m]->e, xs->ctx) < 0) m = r;
+        if (m == i)
+            return;
+        struct run_cursor *tmp = heap[i];
+        heap[i] = heap[m];
+        heap[m] = tmp;
+        i = m;
+    }
+}
+
+// Merge runs[first..first + count)
+static int merge_runs(struct extsort *xs, int first, int count, entry_emit_fn emit, void *arg) {
+    struct run_cursor *cursors = calloc(count ? count : 1, sizeof(*cursors));
+    struct run_cursor **heap = calloc(count ? count : 1, sizeof(*heap));
+    int n = 0, rc = 0;
+
+    if (!cursors || !heap) {
+        free(cursors);
+        free(heap);
+        return -1;
+    }
+
+    for (int i = 0; i < count; i++) {
+        cursors[i].fp = xs->runs[first + i];
+        int got = cursor_next(&cursors[i]);
+        if (got == -1) { rc = -1; goto out; }
+        if (got == 1)
+            heap[n++] = &cursors[i];
+    }
+    for (int i = n / 2 - 1; i >= 0; i--)
+        heap_sift_down(heap, n, i, xs);
+
+    while (n > 0) {
+        struct run_cursor *top = heap[0];
+        emit(&top->e, arg);
+
+        int got = cursor_next(top);
+        if (got == -1) { rc = -1; goto out; }
+        if (got == 0)
+            heap[0] = heap[--n];
+        heap_sift_down(heap, n, 0, xs);
+    }
+
+out:
+    free(cursors);
+    free(heap);
+    return rc;
+}
+
+struct compact_state {
+    FILE *fp;
+    int failed;
+};
+
+static void compact_emit(const struct entry *e, void *arg) {
+    struct compact_state *cs = arg;
+    if (!cs->failed && run_write(e, cs->fp) == -1)
+        cs->failed = 1;
+}
+
+// Replace the newest count runs with one run holding their merge
+static int compact_tail(struct extsort *xs, int count, int level) {
+    struct compact_state cs = { run_create(), 0 };
+    int first = xs->nruns - count;
+    if (!cs.fp)
+        return -1;
+
+    if (merge_runs(xs, first, count, compact_emit, &cs) == -1 || cs.failed ||
+        run_rewind(cs.fp) == -1) {
+        fclose(cs.fp);
+        return -1;
+    }
+
+    for (int i = first; i < xs->nruns; i++)
+        fclose(xs->runs[i]);
+    xs->runs[first] = cs.fp;
+    xs->levels[first] = level;
+    xs->nruns = first + 1;
+    return 0;
+}
+
+// Once the newest EXTSORT_MAX_RUNS runs share a level, merge them
+// into one run of the next level, and carry upwards
+static int promote_runs(struct extsort *xs) {
+    while (xs->nruns >= EXTSORT_MAX_RUNS) {
+        int level = xs->levels[xs->nruns - 1];
+        if (xs->levels[xs->nruns - EXTSORT_MAX_RUNS] != level)
+            break;
+        if (compact_tail(xs, EXTSORT_MAX_RUNS, level + 1) == -1)
+            return -1;
+    }
+    return 0;
+}
+
+int extsort_merge(struct extsort *xs, entry_emit_fn emit, void *arg) {
+    // Leveling leaves up to EXTSORT_MAX_RUNS - 1 runs per level; fold
+    // the newest (smallest) ones so the final merge stays in bounds
+    if (xs->nruns > EXTSORT_MAX_RUNS &&
+        compact_tail(xs, xs->nruns - EXTSORT_MAX_RUNS + 1, xs->levels[EXTSORT_MAX_RUNS - 1]) == -1)
+        return -1;
+    return merge_runs(xs, 0, xs->nruns, emit, arg);
+}
+
+int extsort_spill(struct extsort *xs, struct entry *entries, int count) {
+    if (xs->nruns >= xs->capacity) {
+        int capacity = xs->capacity ? xs->capacity * 2 : 16;
+        FILE **runs = realloc(xs->runs, capacity * sizeof(*runs));
+        if (!runs)
+            return -1;
+        xs->runs = runs;
+        int *levels = realloc(xs->levels, capacity * sizeof(*levels));
+        if (!levels)
+            return -1;
+        xs->levels = levels;
+        xs->capacity = capacity;
+    }
+
+    FILE *fp = run_create();
+    if (!fp)
+        return -1;
+
+    for (int i = 0; i < count; i++) {
+        if (run_write(&entries[i], fp) == -1) {
+            fclose(fp);
+            return -1;
+        }
+    }
+    if (run_rewind(fp) == -1) {
+        fclose(fp);
+        return -1;
+    }
+
+    xs->levels[xs->nruns] = 0;
+    xs->runs[xs->nruns++] = fp;
+    return promote_runs(xs);
+}
+
+void extsort_free(struct extsort *xs) {
+    for (int i = 0; i < xs->nruns; i++)
+        fclose(xs->runs[i]);
+    free(xs->runs);
+    free(xs->levels);
+    extsort_init(xs, xs->cmp, xs->ctx);
+}
@@ -0,0 +1,51 @@
+/* ===========================================================
+ * extsort.h - External merge sort for entry tables over budget
+ *
+ * When a directory does not fit in the --mem-limit budget, each
+ * full in-memory run is sorted by the caller and spilled to an
+ * unlinked temporary file in $TMPDIR (default /tmp).  The final
+ * listing is produced by a k-way merge over the runs with the same
+ * comparison function, so the order is exactly that of an in-memory
+ * sort.
+ *
+ * Runs are leveled: EXTSORT_MAX_RUNS runs of one level are merged
+ * into a single run of the next, so every entry is rewritten once
+ * per level, a logarithmic number of times.
+ * =========================================================== */
+#ifndef LSV_EXTSORT_H
+#define LSV_EXTSORT_H
+
+#include <stdio.h>
+
+#include "entry.h"
+
+// Fan-in of every merge: runs of one level merged at a time, and the
+// most runs the final merge reads at once
+#define EXTSORT_MAX_RUNS 128
+
+// Comparator on two entries; ctx is passed through unchanged
+typedef int (*entry_cmp_fn)(const struct entry *a, const struct entry *b, const void *ctx);
+typedef void (*entry_emit_fn)(const struct entry *e, void *arg);
+
+struct extsort {
+    FILE **runs;             // oldest first, so levels never increase
+    int *levels;             // merges each run has been through
+    int nruns;
+    int capacity;
+    entry_cmp_fn cmp;
+    const void *ctx;
+};
+
+void extsort_init(struct extsort *xs, entry_cmp_fn cmp, const void *ctx);
+
+// Write entries[0..count), already sorted in xs->cmp order, out as a
+// new run.  Returns 0 or -1 with errno set.
+int extsort_spill(struct extsort *xs, struct entry *entries, int count);
+
+// Merge all runs and hand every entry to emit() in sorted order.
+// The entry is only valid during the callback.  Returns 0 or -1.
+int extsort_merge(struct extsort *xs, entry_emit_fn emit, void *arg);
+
+void extsort_free(struct extsort *xs);
+
+#endif
@@ -0,0 +1,234 @@
+#define _GNU_SOURCE
+#include <string.h>
+#include <sys/stat.h>
+
+#include "format.h"
+#include "idcache.h"
+
+// ==============================
+// Names
+// ==============================
+
+// Length of the valid UTF-8 sequence at s, or 0 if it is not one
+static size_t utf8_len(const unsigned char *s, size_t n) {
+    unsigned char c = s[0];
+    size_t len;
+    unsigned int cp;
+
+    if (c < 0x80) return 1;
+    if (c >= 0xc2 && c <= 0xdf) { len = 2; cp = c & 0x1f; }
+    else if (c >= 0xe0 && c <= 0xef) { len = 3; cp = c & 0x0f; }
+    else if (c >= 0xf0 && c <= 0xf4) { len = 4; cp = c & 0x07; }
+    else return 0;
+
+    if (n < len)
+        return 0;
+    for (size_t i = 1; i < len; i++) {
+        if ((s[i] & 0xc0) != 0x80)
+            return 0;
+        cp = (cp << 6) | (s[i] & 0x3f);
+    }
+    // Overlong forms, surrogates and code points past U+10FFFF
+    if ((len == 3 && cp < 0x800) || (len == 4 && cp < 0x10000) ||
+        (cp >= 0xd800 && cp <= 0xdfff) || cp > 0x10ffff)
+        return 0;
+    return len;
+}
+
+// Body of a JSON string; invalid UTF-8 bytes become U+FFFD.
+// Returns non-zero if any byte had to be replaced.
+static int json_chars(struct outbuf *out, const char *s, size_t n) {
+    static const char hex[] = "0123456789abcdef";
+    const unsigned char *p = (const unsigned char *)s;
+    int lossy = 0;
+    size_t run = 0;          // pending bytes that need no escaping
+
+    for (size_t i = 0; i < n;) {
+        unsigned char c = p[i];
+        size_t len = 1;
+        if (c >= 0x20 && c != '"' && c != '\\' && (c < 0x80 || (len = utf8_len(p + i, n - i)))) {
+            run += len;
+            i += len;
+            continue;
+        }
+
+        out_write(out, s + i - run, run);
+        run = 0;
+        if (c == '"' || c == '\\') {
+            char esc[2] = { '\\', (char)c };
+            out_write(out, esc, 2);
+        } else if (c == '\n') {
+            out_write(out, "\\n", 2);
+        } else if (c == '\t') {
+            out_write(out, "\\t", 2);
+        } else if (c < 0x20) {
+            char esc[6] = { '\\', 'u', '0', '0', hex[c >> 4], hex[c & 15] };
+            out_write(out, esc, 6);
+        } else {
+            out_write(out, "\\ufffd", 6);
+            lossy = 1;
+        }
+        i++;
+    }
+    out_write(out, s + n - run, run);
+    return lossy;
+}
+
+static void hex_chars(struct outbuf *out, const char *s, size_t n) {
+    static const char hex[] = "0123456789abcdef";
+    for (size_t i = 0; i < n; i++) {
+        unsigned char c = (unsigned char)s[i];
+        char pair[2] = { hex[c >> 4], hex[c & 15] };
+        out_write(out, pair, 2);
+    }
+}
+
+// Length of the separator between prefix and name: 0 or 1
+static size_t joiner(const char *prefix, size_t plen) {
+    return plen > 0 && prefix[plen - 1] != '/';
+}
+
+// ==============================
+// Formats
+// ==============================
+
+static void write_nul(struct outbuf *out, const char *prefix, size_t plen,
+                      const struct entry *e) {
+    if (prefix) {
+        out_write(out, prefix, plen);
+        out_write(out, "/", joiner(prefix, plen));
+    }
+    out_write(out, e->name, e->namelen);
+    out_char(out, '\0');
+}
+
+static const char *type_name(mode_t mode) {
+    switch (mode & S_IFMT) {
+    case S_IFREG:  return "file";
+    case S_IFDIR:  return "dir";
+    case S_IFLNK:  return "symlink";
+    case S_IFIFO:  return "fifo";
+    case S_IFSOCK: return "socket";
+    case S_IFBLK:  return "block";
+    case S_IFCHR:  return "char";
+    default:       return "unknown";
+    }
+}
+
+static void json_field_num(struct outbuf *out, const char *key, long long v) {
+    out_puts(out, key);
+    out_num_right(out, v, 0);
+}
+
+static void json_field_name(struct outbuf *out, const char *key, const char *name) {
+    out_puts(out, key);
+    if (!name) {
+        out_write(out, "null", 4);
+        return;
+    }
+    out_char(out, '"');
+    json_chars(out, name, strlen(name));
+    out_char(out, '"');
+}
+
+static void write_jsonl(struct outbuf *out, const char *prefix, size_t plen,
+                        const struct entry *e) {
+    const struct file_meta *m = &e->meta;
+    int lossy = 0;
+
+    out_write(out, "{\"name\":\"", 9);
+    if (prefix) {
+        lossy |= json_chars(out, prefix, plen);
+        out_write(out, "/", joiner(prefix, plen));
+    }
+    lossy |= json_chars(out, e->name, e->namelen);
+    out_char(out, '"');
+
+    if (lossy) {
+        out_write(out, ",\"name_hex\":\"", 13);
+        if (prefix) {
+            hex_chars(out, prefix, plen);
+            hex_chars(out, "/", joiner(prefix, plen));
+        }
+        hex_chars(out, e->name, e->namelen);
+        out_char(out, '"');
+    }
+
+    if (m->error) {
+        json_field_name(out, ",\"error\":", strerror(m->error));
+        out_write(out, "}\n", 2);
+        return;
+    }
+
+    json_field_name(out, ",\"type\":", type_name(m->mode));
+    json_field_num(out, ",\"ino\":", (long long)e->ino);
+    json_field_num(out, ",\"mode\":", (long long)m->mode);
+    json_field_num(out, ",\"nlink\":", (long long)m->nlink);
+    json_field_num(out, ",\"uid\":", (long long)m->uid);
+    json_field_num(out, ",\"gid\":", (long long)m->gid);
+    json_field_name(out, ",\"user\":", idcache_user(m->uid));
+    json_field_name(out, ",\"group\":", idcache_group(m->gid));
+    json_field_num(out, ",\"size\":", (long long)m->size);
+    json_field_num(out, ",\"mtime_ns\":",
+                   (long long)m->mtime.tv_sec * 1000000000LL + m->mtime.tv_nsec);
+    out_write(out, "}\n", 2);
+}
+
+static void write_binary(struct outbuf *out, const char *prefix, size_t plen,
+                         const struct entry *e) {
+    static const char zeros[8];
+    const struct file_meta *m = &e->meta;
+    struct lsv_record r;
+    size_t sep = prefix ? joiner(prefix, plen) : 0;
+    size_t namelen = (prefix ? plen + sep : 0) + e->namelen;
+
+    memset(&r, 0, sizeof(r));
+    r.ino = e->ino;
+    r.namelen = (uint32_t)namelen;
+    if (m->error) {
+        r.mode = m->mode & S_IFMT;
+        r.flags = LSV_RECORD_ERROR;
+    } else {
+        r.nlink = m->nlink;
+        r.size = m->size;
+        r.mtime_ns = (int64_t)m->mtime.tv_sec * 1000000000LL + m->mtime.tv_nsec;
+        r.mode = m->mode;
+        r.uid = m->uid;
+        r.gid = m->gid;
+    }
+
+    out_write(out, (const char *)&r, sizeof(r));
+    if (prefix) {
+        out_write(out, prefix, plen);
+        out_write(out, "/", sep);
+    }
+    out_write(out, e->name, e->namelen);
+    out_write(out, zeros, (8 - namelen % 8) % 8);
+}
+
+void format_begin(enum output_format fmt, struct outbuf *out) {
+    if (fmt != FORMAT_BINARY)
+        return;
+
+    struct lsv_binary_header h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, LSV_BINARY_MAGIC, sizeof(h.magic));
+    h.version = LSV_BINARY_VERSION;
+    h.record_size = sizeof(struct lsv_record);
+    h.byte_order = 0x01020304u;
+    out_write(out, (const char *)&h, sizeof(h));
+}
+
+void format_entries(enum output_format fmt, struct outbuf *out, const char *prefix,
+                    const struct entry *entries, int count) {
+    size_t plen = prefix ? strlen(prefix) : 0;
+
+    for (int i = 0; i < count; i++) {
+        switch (fmt) {
+        case FORMAT_NUL:    write_nul(out, prefix, plen, &entries[i]); break;
+        case FORMAT_JSONL:  write_jsonl(out, prefix, plen, &entries[i]); break;
+        case FORMAT_BINARY: write_binary(out, prefix, plen, &entries[i]); break;
+        case FORMAT_TEXT:   break;
+        }
+    }
+}
@@ -0,0 +1,82 @@
+/* ===========================================================
+ * format.h - Machine-readable output (--format=nul|jsonl|binary)
+ *
+ * nul     each name followed by a NUL byte, nothing else
+ * jsonl   one JSON object per line:
+ *           {"name":..,"type":..,"ino":..,"mode":..,"nlink":..,
+ *            "uid":..,"gid":..,"user":..,"group":..,"size":..,
+ *            "mtime_ns":..}
+ *         "mode" is the full st_mode as an integer; "user" and
+ *         "group" are null for ids without a name.  Names that are
+ *         not valid UTF-8 carry U+FFFD in "name" and the raw bytes
+ *         in "name_hex".  A failed lookup gives {"name":..,"error":..}.
+ * binary  a stream header followed by one record per entry, both
+ *         laid out below.  Nothing is formatted: every field is
+ *         copied from the gathered metadata.
+ *
+ * With several directories or -R, names are prefixed with their
+ * directory ("dir/name") instead of printing "dir:" headers.
+ * =========================================================== */
+#ifndef LSV_FORMAT_H
+#define LSV_FORMAT_H
+
+#include <stdint.h>
+
+#include "entry.h"
+#include "outbuf.h"
+
+enum output_format {
+    FORMAT_TEXT,             // the human-oriented displays
+    FORMAT_NUL,
+    FORMAT_JSONL,
+    FORMAT_BINARY,
+};
+
+/* ---- Binary format, version 1 ----------------------------------
+ *
+ * All integers are in the writer's byte order; byte_order reads as
+ * 0x01020304 when it matches the reader's.  The stream is the
+ * header, then records back to back until end of file.  Each record
+ * is the fixed 56-byte part below followed by namelen name bytes
+ * (no terminator), zero-padded to a multiple of 8, so every record
+ * starts 8-byte aligned and the stream can be mapped and walked
+ * in place.  Readers skip unknown flags bits and must use
+ * record_size to find the name, so later versions can append fields.
+ * ---------------------------------------------------------------- */
+#define LSV_BINARY_MAGIC   "LSVB"
+#define LSV_BINARY_VERSION 1
+
+// Metadata could not be read: only ino, the type bits of mode and
+// the name are meaningful
+#define LSV_RECORD_ERROR   0x0001u
+
+struct lsv_binary_header {
+    char magic[4];           // "LSVB"
+    uint16_t version;        // LSV_BINARY_VERSION
+    uint16_t record_size;    // sizeof(struct lsv_record), 56 in version 1
+    uint32_t byte_order;     // 0x01020304
+    uint32_t reserved;       // 0
+};
+
+struct lsv_record {
+    uint64_t ino;
+    uint64_t nlink;
+    int64_t size;
+    int64_t mtime_ns;        // nanoseconds since the epoch
+    uint32_t mode;           // st_mode: type and permission bits
+    uint32_t uid;
+    uint32_t gid;
+    uint32_t namelen;        // wide enough for any joined -R path
+    uint32_t flags;          // LSV_RECORD_*
+    uint32_t reserved;       // 0
+};
+
+// Written once at the start of a binary stream
+void format_begin(enum output_format fmt, struct outbuf *out);
+
+// Write entries in a machine format.  prefix, when not NULL, is the
+// directory joined in front of every name.
+void format_entries(enum output_format fmt, struct outbuf *out, const char *prefix,
+                    const struct entry *entries, int count);
+
+#endif
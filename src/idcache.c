@@ -0,0 +1,172 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <pwd.h>
+#include <grp.h>
+
+#include "arena.h"
+#include "idcache.h"
+#include "stats.h"
+
+struct id_slot {
+    unsigned int id;
+    int used;
+    const char *name;        // NULL for a negative entry
+};
+
+struct id_map {
+    struct id_slot *slots;
+    unsigned int capacity;   // power of two
+    unsigned int count;
+};
+
+static struct id_map users, groups;
+static struct arena id_names;
+static int names_ready;
+static int local_only;       // set by idcache_preload()
+static pthread_mutex_t id_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static unsigned int id_hash(unsigned int id) {
+    id ^= id >> 16;
+    id *= 0x45d9f3bu;
+    id ^= id >> 16;
+    return id;
+}
+
+static struct id_slot *id_map_find(struct id_map *m, unsigned int id) {
+    if (!m->slots)
+        return NULL;
+    unsigned int mask = m->capacity - 1;
+    for (unsigned int i = id_hash(id) & mask;; i = (i + 1) & mask) {
+        struct id_slot *s = &m->slots[i];
+        if (!s->used)
+            return NULL;
+        if (s->id == id)
+            return s;
+    }
+}
+
+static int id_map_grow(struct id_map *m) {
+    unsigned int capacity = m->capacity ? m->capacity * 2 : 64;
+    struct id_slot *slots = calloc(capacity, sizeof(*slots));
+    if (!slots)
+        return -1;
+
+    for (unsigned int i = 0; i < m->capacity; i++) {
+        struct id_slot *old = &m->slots[i];
+        if (!old->used)
+            continue;
+        unsigned int j = id_hash(old->id) & (capacity - 1);
+        while (slots[j].used)
+            j = (j + 1) & (capacity - 1);
+        slots[j] = *old;
+    }
+    free(m->slots);
+    m->slots = slots;
+    m->capacity = capacity;
+    return 0;
+}
+
+// Insert or overwrite; name is copied.  Failure just means no caching.
+static const char *id_map_put(struct id_map *m, unsigned int id, const char *name) {
+    if (!names_ready) {
+        arena_init(&id_names);
+        names_ready = 1;
+    }
+    const char *copy = name ? arena_strndup(&id_names, name, strlen(name)) : NULL;
+
+    struct id_slot *s = id_map_find(m, id);
+    if (!s) {
+        if ((m->count + 1) * 10 > m->capacity * 7 && id_map_grow(m) == -1)
+            return copy;
+        unsigned int mask = m->capacity - 1;
+        unsigned int i = id_hash(id) & mask;
+        while (m->slots[i].used)
+            i = (i + 1) & mask;
+        s = &m->slots[i];
+        s->used = 1;
+        s->id = id;
+        m->count++;
+    }
+    s->name = copy;
+    return copy;
+}
+
+const char *idcache_user(uid_t uid) {
+    pthread_mutex_lock(&id_lock);
+    const char *name;
+    struct id_slot *s = id_map_find(&users, (unsigned int)uid);
+    if (s) {
+        name = s->name;
+    } else {
+        struct passwd *pw = NULL;
+        if (!local_only) {
+            stats_begin(STATS_IDS);
+            stats_add(STATS_NSS, 1);
+            pw = getpwuid(uid);
+            stats_end(STATS_IDS);
+        }
+        name = id_map_put(&users, (unsigned int)uid, pw ? pw->pw_name : NULL);
+    }
+    pthread_mutex_unlock(&id_lock);
+    return name;
+}
+
+const char *idcache_group(gid_t gid) {
+    pthread_mutex_lock(&id_lock);
+    const char *name;
+    struct id_slot *s = id_map_find(&groups, (unsigned int)gid);
+    if (s) {
+        name = s->name;
+    } else {
+        struct group *gr = NULL;
+        if (!local_only) {
+            stats_begin(STATS_IDS);
+            stats_add(STATS_NSS, 1);
+            gr = getgrgid(gid);
+            stats_end(STATS_IDS);
+        }
+        name = id_map_put(&groups, (unsigned int)gid, gr ? gr->gr_name : NULL);
+    }
+    pthread_mutex_unlock(&id_lock);
+    return name;
+}
+
+// Parse "name:passwd:id:..." lines; the first entry for an id wins,
+// matching what getpwuid()/getgrgid() return for the files backend.
+static int preload_file(const char *path, struct id_map *m) {
+    FILE *fp = fopen(path, "r");
+    if (!fp)
+        return -1;
+
+    char line[1024];
+    while (fgets(line, sizeof(line), fp)) {
+        char *name = line;
+        char *p = strchr(name, ':');
+        if (!p || name[0] == '#' || name[0] == '+' || name[0] == '-')
+            continue;
+        *p = '\0';
+        p = strchr(p + 1, ':');
+        if (!p)
+            continue;
+
+        char *end;
+        unsigned long id = strtoul(p + 1, &end, 10);
+        if (end == p + 1 || *end != ':')
+            continue;
+        if (!id_map_find(m, (unsigned int)id))
+            id_map_put(m, (unsigned int)id, name);
+    }
+    fclose(fp);
+    return 0;
+}
+
+int idcache_preload(void) {
+    pthread_mutex_lock(&id_lock);
+    int rc_users = preload_file("/etc/passwd", &users);
+    int rc_groups = preload_file("/etc/group", &groups);
+    local_only = 1;
+    pthread_mutex_unlock(&id_lock);
+    return (rc_users == -1 && rc_groups == -1) ? -1 : 0;
+}
@@ -0,0 +1,23 @@
+/* ===========================================================
+ * idcache.h - uid/gid to name cache for long listing
+ *
+ * A directory usually has a handful of distinct owners, but
+ * getpwuid()/getgrgid() can each cost an NSS round trip (SSSD,
+ * LDAP).  Every id is resolved at most once per run; ids with no
+ * name are cached as negative entries too.
+ * =========================================================== */
+#ifndef LSV_IDCACHE_H
+#define LSV_IDCACHE_H
+
+#include <sys/types.h>
+
+// Name for uid/gid, or NULL if the id has no name.  Thread-safe.
+const char *idcache_user(uid_t uid);
+const char *idcache_group(gid_t gid);
+
+// Fill the cache from /etc/passwd and /etc/group and stop consulting
+// NSS: ids not found there are treated as unnamed.  Returns 0, or -1
+// if neither file could be read.
+int idcache_preload(void);
+
+#endif
@@ -0,0 +1,317 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <dirent.h>
+#include <fnmatch.h>
+#include <sys/stat.h>
+
+#include "colors.h"
+#include "idcache.h"
+#include "lsv.h"
+#include "meta.h"
+#include "stats.h"
+#include "statpool.h"
+#include "uring.h"
+
+// ==============================
+// Helper: Print colorized filename
+// ==============================
+// Colors come from LS_COLORS (see colors.c), parsed once in lsv_init()
+void lsv_print_colorized_name(struct outbuf *out, const struct entry *e) {
+    const struct color_seq *color = color_of(e);
+    const struct color_seq *reset = color_reset();
+    out_write(out, color->seq, color->len);
+    out_write(out, e->name, e->namelen);
+    out_write(out, reset->seq, reset->len);
+}
+
+// ==============================
+// Helper: Permission string (type + rwx bits)
+// ==============================
+void lsv_format_permissions(mode_t mode, char *perm) {
+    strcpy(perm, "----------");
+
+    if (S_ISDIR(mode))  perm[0] = 'd';
+    if (S_ISLNK(mode))  perm[0] = 'l';
+    if (S_ISCHR(mode))  perm[0] = 'c';
+    if (S_ISBLK(mode))  perm[0] = 'b';
+    if (S_ISFIFO(mode)) perm[0] = 'p';
+    if (S_ISSOCK(mode)) perm[0] = 's';
+
+    if (mode & S_IRUSR) perm[1] = 'r';
+    if (mode & S_IWUSR) perm[2] = 'w';
+    if (mode & S_IXUSR) perm[3] = 'x';
+    if (mode & S_IRGRP) perm[4] = 'r';
+    if (mode & S_IWGRP) perm[5] = 'w';
+    if (mode & S_IXGRP) perm[6] = 'x';
+    if (mode & S_IROTH) perm[7] = 'r';
+    if (mode & S_IWOTH) perm[8] = 'w';
+    if (mode & S_IXOTH) perm[9] = 'x';
+}
+
+// ==============================
+// Helper: Owner / group column
+// ==============================
+// Like ls, an id with no name is shown as the number itself
+static void print_id(struct outbuf *out, const char *name, unsigned long id) {
+    char num[24];
+    if (!name) {
+        snprintf(num, sizeof(num), "%lu", id);
+        name = num;
+    }
+    out_str_left(out, name, 8);
+}
+
+// ==============================
+// Display functions
+// ==============================
+
+// Horizontal display (-x)
+// first is the position of entries[0] in the whole listing, so a
+// streamed listing can be rendered batch by batch; the caller ends
+// the last row.
+void lsv_print_horizontal_listing(struct outbuf *out, const struct entry *entries, int count, long first) {
+    for (int i = 0; i < count; i++) {
+        lsv_print_colorized_name(out, &entries[i]);
+        out_pad(out, 20);
+        if ((first + i + 1) % 5 == 0)
+            out_char(out, '\n');
+    }
+}
+
+// Long display (-l)
+// Metadata was gathered during the scan (see meta_fetch_all), so this
+// loop only formats; a failed lookup is handed to opt->on_error in its
+// sorted position and gets no row.
+// tf carries the mtime formatting cache across calls, so listings
+// rendered in pieces (streaming, merge) keep its hit rate.
+void lsv_print_long_listing(struct outbuf *out, struct timefmt *tf, const struct lsv_options *opt,
+                            const struct entry *entries, int count) {
+    char perm[11];
+    char timebuf[32];
+
+    for (int i = 0; i < count; i++) {
+        const struct entry *e = &entries[i];
+        const struct file_meta *meta = &e->meta;
+        if (meta->error) {
+            if (opt->on_error)
+                opt->on_error(e->name, meta->error, opt->error_arg);
+            continue;
+        }
+
+        lsv_format_permissions(meta->mode, perm);
+
+        const char *owner = idcache_user(meta->uid);
+        const char *group = idcache_group(meta->gid);
+
+        size_t tlen = timefmt_mtime(tf, meta->mtime.tv_sec, timebuf);
+
+        // "%s %2ld %-8s %-8s %8lld %s "
+        out_write(out, perm, 10);
+        out_char(out, ' ');
+        out_num_right(out, (long long)meta->nlink, 2);
+        out_char(out, ' ');
+        print_id(out, owner, meta->uid);
+        out_char(out, ' ');
+        print_id(out, group, meta->gid);
+        out_char(out, ' ');
+        out_num_right(out, (long long)meta->size, 8);
+        out_char(out, ' ');
+        out_write(out, timebuf, tlen);
+        out_char(out, ' ');
+        lsv_print_colorized_name(out, e);
+        out_char(out, '\n');
+    }
+}
+
+// Default (vertical) display
+void lsv_print_vertical_listing(struct outbuf *out, const struct entry *entries, int count) {
+    for (int i = 0; i < count; i++) {
+        lsv_print_colorized_name(out, &entries[i]);
+        out_char(out, '\n');
+    }
+}
+
+// ==============================
+// Building blocks
+// ==============================
+
+// Gather metadata once; coloring needs the mode, -l needs the rest
+// and -t/-S their sort key.  io_uring falls back to the synchronous
+// path when unavailable.
+unsigned lsv_wanted_fields(const struct lsv_options *opt) {
+    int all = opt->long_flag || opt->format == FORMAT_JSONL || opt->format == FORMAT_BINARY;
+    unsigned want = all ? META_LONG : (META_TYPE | META_MODE);
+    if (opt->sort.field == SORT_MTIME) want |= META_MTIME;
+    if (opt->sort.field == SORT_SIZE) want |= META_SIZE;
+    return want;
+}
+
+int lsv_skip_entry(const struct lsv_options *opt, const struct dirscan_entry *de) {
+    if (!opt->show_all && de->name[0] == '.')
+        return 1; // skip hidden files
+    if (opt->glob && fnmatch(opt->glob, de->name, 0) != 0)
+        return 1;
+    if (opt->regex && regexec(opt->regex, de->name, 0, NULL, 0) != 0)
+        return 1;
+    return 0;
+}
+
+void lsv_fetch_metadata(const struct lsv_options *opt, int dirfd, struct entry *entries,
+                        int count) {
+    unsigned want = lsv_wanted_fields(opt);
+    stats_begin(STATS_META);
+
+    // Plain listings only need the file type, which the dirent
+    // usually carries; stat only DT_UNKNOWN entries and, with
+    // --mode-colors, those whose color depends on permission bits.
+    // --format=nul needs no type
+    // at all except to find directories for -R.  --no-stat never stats.
+    if (want == (META_TYPE | META_MODE)) {
+        int pending = 0;
+        for (int i = 0; i < count; i++) {
+            struct entry *e = &entries[i];
+            int need = opt->format == FORMAT_TEXT ? colors_need_mode(e->d_type)
+                                                  : opt->find_dirs && e->d_type == DT_UNKNOWN;
+            if (!opt->no_stat && need)
+                pending++;
+            else
+                meta_from_dtype(e->d_type, &e->meta);
+        }
+        if (pending == 0 || opt->no_stat) {
+            stats_end(STATS_META);
+            return;
+        }
+    }
+
+    if (!opt->use_uring || meta_fetch_all_uring(dirfd, entries, count, want) == -1)
+        meta_fetch_all(dirfd, entries, count, want, opt->jobs);
+    stats_end(STATS_META);
+}
+
+void lsv_renderer_init(struct lsv_renderer *r, const struct lsv_options *opt,
+                       struct outbuf *out, const char *prefix) {
+    r->opt = opt;
+    r->out = out;
+    r->shown = 0;
+    r->prefix = prefix;
+    timefmt_init(&r->tf);
+}
+
+void lsv_render_entries(struct lsv_renderer *r, const struct entry *entries, int count) {
+    const struct lsv_options *opt = r->opt;
+
+    // Machine formats carry the directory in each name instead of a
+    // "dir:" header
+    if (opt->format != FORMAT_TEXT)
+        format_entries(opt->format, r->out, r->prefix, entries, count);
+    else if (opt->long_flag)
+        lsv_print_long_listing(r->out, &r->tf, opt, entries, count);
+    else if (opt->horiz_flag)
+        lsv_print_horizontal_listing(r->out, entries, count, r->shown);
+    else
+        lsv_print_vertical_listing(r->out, entries, count);
+    r->shown += count;
+    stats_add(STATS_ENTRIES, count);
+}
+
+void lsv_render_finish(struct lsv_renderer *r) {
+    if (r->opt->horiz_flag && !r->opt->long_flag && r->opt->format == FORMAT_TEXT)
+        out_char(r->out, '\n');
+}
+
+// ==============================
+// Listings
+// ==============================
+
+int lsv_init(const char *ls_colors, int mode_colors) {
+    return colors_init(ls_colors, mode_colors);
+}
+
+int lsv_out_init(struct outbuf *o, int fd, size_t cap) {
+    return out_init(o, fd, cap);
+}
+
+int lsv_out_init_mem(struct outbuf *o, size_t cap) {
+    return out_init_mem(o, cap);
+}
+
+int lsv_out_flush(struct outbuf *o) {
+    return out_flush(o);
+}
+
+int lsv_out_close(struct outbuf *o) {
+    return out_close(o);
+}
+
+void lsv_listing_init(struct lsv_listing *l, const struct lsv_options *opt,
+                      char *buf, size_t size) {
+    l->opt = *opt;
+    entry_table_init(&l->table);
+    l->scanbuf = buf;
+    l->scanbuf_size = buf ? size : DIRSCAN_DEFAULT_BUFSIZE;
+    l->own_scanbuf = 0;
+}
+
+int lsv_scan(struct lsv_listing *l, int dirfd) {
+    struct dirscan ds;
+    struct dirscan_entry de;
+    int rc;
+
+    if (!l->scanbuf) {
+        l->scanbuf = malloc(l->scanbuf_size);
+        if (!l->scanbuf)
+            return -1;
+        l->own_scanbuf = 1;
+    }
+    entry_table_clear(&l->table);
+    dirscan_fdopen(&ds, dirfd, l->scanbuf, l->scanbuf_size);
+    if (dirscan_rewind(&ds) == -1)
+        return -1;
+
+    stats_begin(STATS_SCAN);
+    while ((rc = dirscan_next(&ds, &de)) == 1) {
+        if (lsv_skip_entry(&l->opt, &de)) continue;
+        if (!entry_table_add(&l->table, &de)) {
+            rc = -1;
+            errno = ENOMEM;
+            break;
+        }
+    }
+    stats_end(STATS_SCAN);
+    stats_max(STATS_TABLE_PEAK, entry_table_bytes(&l->table));
+    if (rc == -1)
+        return -1;
+
+    lsv_fetch_metadata(&l->opt, dirfd, l->table.items, l->table.count);
+    return 0;
+}
+
+void lsv_sort(struct lsv_listing *l) {
+    if (l->opt.unsorted)
+        return;
+    stats_begin(STATS_SORT);
+    sort_entries(&l->opt.sort, l->table.items, l->table.count);
+    stats_end(STATS_SORT);
+}
+
+int lsv_render(const struct lsv_listing *l, struct outbuf *out) {
+    struct lsv_renderer r;
+
+    lsv_renderer_init(&r, &l->opt, out, NULL);
+    stats_begin(STATS_RENDER);
+    lsv_render_entries(&r, l->table.items, l->table.count);
+    stats_end(STATS_RENDER);
+    lsv_render_finish(&r);
+    return out->error ? -1 : 0;
+}
+
+void lsv_listing_free(struct lsv_listing *l) {
+    entry_table_free(&l->table);
+    if (l->own_scanbuf)
+        free(l->scanbuf);
+    l->scanbuf = NULL;
+    l->own_scanbuf = 0;
+}
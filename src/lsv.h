@@ -0,0 +1,177 @@
+/* ===========================================================
+ * lsv.h - liblsv: directory listings as a library
+ *
+ * Scan, sort and render one directory in-process, with the same
+ * output as bin/lsv, instead of paying fork/exec per listing.
+ *
+ *     struct lsv_listing l;
+ *     lsv_init(getenv("LS_COLORS"), 0);           // once per process
+ *     lsv_listing_init(&l, &opts, NULL, 0);
+ *     lsv_scan(&l, dirfd);
+ *     lsv_sort(&l);
+ *     lsv_render(&l, &out);                       // or iterate entries
+ *     lsv_listing_free(&l);
+ *
+ * A listing keeps its entry table, name arena and getdents64 buffer
+ * between scans, so scanning the next directory reuses them.
+ *
+ * Thread safety: after lsv_init() every call may run on any thread
+ * as long as each struct lsv_listing (and each outbuf, and each
+ * directory fd) is used by one thread at a time.  The shared state
+ * behind them (colors, the uid/gid cache, --stats counters) is
+ * either read-only after lsv_init() or locked.
+ *
+ * The lower-level calls further down are the pieces the CLI builds
+ * its streaming, spilling and recursive modes from.
+ *
+ * liblsv.so exports only the lsv_* functions below (LSV_API); the
+ * headers included here supply the types, not callable symbols.
+ * =========================================================== */
+#ifndef LSV_LSV_H
+#define LSV_LSV_H
+
+#include <stddef.h>
+#include <regex.h>
+
+#include "dirscan.h"
+#include "entry.h"
+#include "format.h"
+#include "outbuf.h"
+#include "sort.h"
+#include "timefmt.h"
+
+// Symbols liblsv.so exports; everything else is built hidden
+#define LSV_API __attribute__((visibility("default")))
+
+// Reports an entry whose metadata lookup failed (errno value err)
+typedef void (*lsv_error_fn)(const char *name, int err, void *arg);
+
+// What one directory's listing looks like
+struct lsv_options {
+    int long_flag;           // -l
+    int horiz_flag;          // -x
+    int unsorted;            // directory order; lsv_sort() leaves it alone
+    int show_all;            // include dot files
+    int jobs;                // stat threads (1 = the calling thread)
+    int use_uring;           // io_uring metadata backend when available
+    int no_stat;             // plain listings never stat, not even DT_UNKNOWN
+    int find_dirs;           // caller descends: always identify directories
+    const char *glob;        // keep only names fnmatch() matches, or NULL
+    const regex_t *regex;    // keep only names this matches, or NULL
+    enum output_format format;   // text or a machine format
+    struct sort_spec sort;
+    lsv_error_fn on_error;   // failed lookups in long listings, or NULL
+    void *error_arg;
+};
+
+// Set up colors from an LS_COLORS string (NULL for the built-in
+// palette).  The permission-based codes (ex, su, sg, st, ow, tw) apply
+// to entries whose mode came from a stat, as in long listings;
+// mode_colors makes plain listings stat every file for them too.
+// Call once before any listing.  Returns 0 or -1.
+LSV_API int lsv_init(const char *ls_colors, int mode_colors);
+
+// ---- Output --------------------------------------------------------
+
+// The outbuf writer (outbuf.h): out_init(), out_init_mem(),
+// out_flush() and out_close() under their exported names
+LSV_API int lsv_out_init(struct outbuf *o, int fd, size_t cap);
+LSV_API int lsv_out_init_mem(struct outbuf *o, size_t cap);
+LSV_API int lsv_out_flush(struct outbuf *o);
+LSV_API int lsv_out_close(struct outbuf *o);
+
+// ---- Listings ------------------------------------------------------
+
+struct lsv_listing {
+    struct lsv_options opt;
+    struct entry_table table;
+    char *scanbuf;           // getdents64 buffer
+    size_t scanbuf_size;
+    int own_scanbuf;
+};
+
+// buf, when not NULL, is a caller-owned getdents64 buffer of size
+// bytes; otherwise one is allocated on the first scan and kept.
+LSV_API void lsv_listing_init(struct lsv_listing *l, const struct lsv_options *opt,
+                              char *buf, size_t size);
+
+// Replace the listing's entries with those of the directory open on
+// dirfd, metadata included, reading from its start.  The fd is not
+// closed.  Returns 0, or -1 with errno set.
+LSV_API int lsv_scan(struct lsv_listing *l, int dirfd);
+
+// Order the entries as opt.sort describes (no-op when unsorted)
+LSV_API void lsv_sort(struct lsv_listing *l);
+
+// Append the listing to out: the display the options select, or a
+// machine format.  A memory writer (lsv_out_init_mem) can be emptied
+// by setting out->len = 0 and reused.  Returns 0, or -1 if out failed.
+LSV_API int lsv_render(const struct lsv_listing *l, struct outbuf *out);
+
+static inline int lsv_count(const struct lsv_listing *l) {
+    return l->table.count;
+}
+
+// Iteration in the current order; entries stay valid until the next
+// lsv_scan() or lsv_listing_free()
+struct lsv_iter {
+    const struct lsv_listing *l;
+    int pos;
+};
+
+static inline void lsv_iter_init(struct lsv_iter *it, const struct lsv_listing *l) {
+    it->l = l;
+    it->pos = 0;
+}
+
+// Next entry, or NULL at the end
+static inline const struct entry *lsv_iter_next(struct lsv_iter *it) {
+    return it->pos < it->l->table.count ? &it->l->table.items[it->pos++] : NULL;
+}
+
+LSV_API void lsv_listing_free(struct lsv_listing *l);
+
+// ---- Building blocks -----------------------------------------------
+
+// META_* fields the options need from every entry
+LSV_API unsigned lsv_wanted_fields(const struct lsv_options *opt);
+
+// Non-zero if the options hide this entry: a dot file without
+// show_all, or a name the glob or regex rejects.  Scan loops call it
+// before copying or stat'ing anything.
+LSV_API int lsv_skip_entry(const struct lsv_options *opt, const struct dirscan_entry *de);
+
+// Fill in entries[].meta, skipping lookups the dirent type answers
+LSV_API void lsv_fetch_metadata(const struct lsv_options *opt, int dirfd,
+                                struct entry *entries, int count);
+
+// A listing rendered in one or more pieces
+struct lsv_renderer {
+    const struct lsv_options *opt;
+    struct outbuf *out;
+    struct timefmt tf;       // mtime formatting cache, kept across pieces
+    long shown;              // entries rendered so far
+    const char *prefix;      // machine formats: directory joined to names
+};
+
+LSV_API void lsv_renderer_init(struct lsv_renderer *r, const struct lsv_options *opt,
+                               struct outbuf *out, const char *prefix);
+LSV_API void lsv_render_entries(struct lsv_renderer *r, const struct entry *entries,
+                                int count);
+
+// Close off the listing (the horizontal layout leaves its last row open)
+LSV_API void lsv_render_finish(struct lsv_renderer *r);
+
+// The displays themselves.  A long listing skips entries whose lookup
+// failed and reports them through opt->on_error.
+LSV_API void lsv_print_colorized_name(struct outbuf *out, const struct entry *e);
+LSV_API void lsv_format_permissions(mode_t mode, char *perm);
+LSV_API void lsv_print_horizontal_listing(struct outbuf *out, const struct entry *entries,
+                                          int count, long first);
+LSV_API void lsv_print_long_listing(struct outbuf *out, struct timefmt *tf,
+                                    const struct lsv_options *opt,
+                                    const struct entry *entries, int count);
+LSV_API void lsv_print_vertical_listing(struct outbuf *out, const struct entry *entries,
+                                        int count);
+
+#endif
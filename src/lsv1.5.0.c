@@ -1,149 +1,992 @@
+#define _GNU_SOURCE
 #include <stdio.h>
+#include <stdio_ext.h>
 #include <stdlib.h>
+#include <stdint.h>
 #include <dirent.h>
 #include <string.h>
+#include <errno.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <locale.h>
+#include <poll.h>
+#include <sys/inotify.h>
 #include <sys/stat.h>
 #include <unistd.h>
+#include <time.h>
 
-// ==============================
-// ANSI Color Codes
-// ==============================
-#define COLOR_RESET     "\033[0m"
-#define COLOR_BLUE      "\033[0;34m"  // Directory
-#define COLOR_GREEN     "\033[0;32m"  // Executable
-#define COLOR_RED       "\033[0;31m"  // Archive files (.tar, .gz, .zip)
-#define COLOR_PINK      "\033[1;35m"  // Symbolic Link
-#define COLOR_REVERSE   "\033[7m"     // Special file
+#include "colors.h"
+#include "dirscan.h"
+#include "entry.h"
+#include "entryset.h"
+#include "extsort.h"
+#include "format.h"
+#include "idcache.h"
+#include "lsv.h"
+#include "meta.h"
+#include "outbuf.h"
+#include "snapshot.h"
+#include "sort.h"
+#include "stats.h"
+#include "statpool.h"
+#include "timefmt.h"
+#include "topn.h"
+#include "walk.h"
 
 // ==============================
-// Helper: Compare two strings for qsort
+// Listing driver
 // ==============================
-int compare_names(const void *a, const void *b) {
-    const char *name1 = *(const char **)a;
-    const char *name2 = *(const char **)b;
-    return strcmp(name1, name2);
+
+// Entries per batch in streaming (-U/-f) mode; bounds memory use
+#define STREAM_BATCH 1024
+
+// Smallest accepted --mem-limit
+#define MIN_MEM_LIMIT (64 * 1024)
+
+struct ls_options {
+    struct lsv_options lsv;  // -l -x -U -f -t -S -r --jobs --meta --no-stat --format --collate
+    int recursive;           // -R
+    int local_ids;
+    int limit;               // --limit: only the first N entries (0 = all)
+    const char *regex_text;  // --regex source, part of the cache key
+    size_t mem_limit;        // --mem-limit: spill sorted runs beyond this (0 = off)
+    const char *cache_dir;   // --cache: snapshot directory, else NULL
+    uint64_t cache_key;      // fingerprint of the options above that shape a table
+};
+
+// State that lives across render calls of one listing
+struct render_state {
+    struct lsv_renderer r;
+    const struct ls_options *opt;
+    struct walk_node *node;  // walker's node: -R collects subdirectories here
+};
+
+// Machine formats carry the directory in each name instead of a
+// "dir:" header (node is set whenever the walker lists)
+static void render_init(struct render_state *rs, const struct ls_options *opt,
+                        struct outbuf *out, struct walk_node *node) {
+    lsv_renderer_init(&rs->r, &opt->lsv, out, node ? node->path : NULL);
+    rs->opt = opt;
+    rs->node = node;
+}
+
+// -R descends into real directories (not symlinks to them), in the
+// order they are listed
+static void queue_subdirs(struct walk_node *node, const struct entry *entries, int count) {
+    for (int i = 0; i < count; i++) {
+        const struct entry *e = &entries[i];
+        if (e->meta.error || !S_ISDIR(e->meta.mode))
+            continue;
+        if (strcmp(e->name, ".") == 0 || strcmp(e->name, "..") == 0)
+            continue;
+        if (walk_add_child(node, e->name, e->namelen) == -1)
+            perror("malloc");
+    }
+}
+
+static void render_entries(struct render_state *rs, const struct entry *entries, int count) {
+    lsv_render_entries(&rs->r, entries, count);
+    if (rs->node && rs->opt->recursive)
+        queue_subdirs(rs->node, entries, count);
+}
+
+static void render_finish(struct render_state *rs) {
+    lsv_render_finish(&rs->r);
+}
+
+static void render_one(const struct entry *e, void *arg) {
+    render_entries(arg, e, 1);
+}
+
+// Read everything, sort, then render.  With --mem-limit, every time
+// the table outgrows the budget it is sorted and spilled as a run,
+// and the output comes from a k-way merge of the runs.
+// A table that stayed in memory is stored in snap when given.
+static int list_sorted(const struct ls_options *opt, struct dirscan *ds, struct outbuf *out,
+                       struct walk_node *node, struct snapshot *snap) {
+    struct dirscan_entry de;
+    struct entry_table table;
+    struct extsort xs;
+    struct render_state rs;
+    int rc, status = 0;
+
+    entry_table_init(&table);
+    extsort_init(&xs, sort_compare, &opt->lsv.sort);
+    render_init(&rs, opt, out, node);
+
+    // Read all entries in large getdents64 batches; spills are
+    // charged to sort (stats phases nest)
+    stats_begin(STATS_SCAN);
+    while ((rc = dirscan_next(ds, &de)) == 1) {
+        if (lsv_skip_entry(&opt->lsv, &de)) continue;
+        if (!entry_table_add(&table, &de)) {
+            perror("malloc");
+            stats_end(STATS_SCAN);
+            status = -1;
+            goto out;
+        }
+        if (opt->mem_limit && entry_table_bytes(&table) > opt->mem_limit) {
+            stats_max(STATS_TABLE_PEAK, entry_table_bytes(&table));
+            lsv_fetch_metadata(&opt->lsv, ds->fd, table.items, table.count);
+            stats_begin(STATS_SORT);
+            sort_entries(&opt->lsv.sort, table.items, table.count);
+            rc = extsort_spill(&xs, table.items, table.count);
+            stats_end(STATS_SORT);
+            if (rc == -1) {
+                perror("spill");
+                stats_end(STATS_SCAN);
+                status = -1;
+                goto out;
+            }
+            entry_table_clear(&table);
+        }
+    }
+    stats_end(STATS_SCAN);
+    if (rc == -1) {
+        perror("getdents64");
+        status = -1;         // the listing below is incomplete
+    }
+    stats_max(STATS_TABLE_PEAK, entry_table_bytes(&table));
+
+    lsv_fetch_metadata(&opt->lsv, ds->fd, table.items, table.count);
+
+    stats_begin(STATS_SORT);
+    sort_entries(&opt->lsv.sort, table.items, table.count);
+    stats_end(STATS_SORT);
+
+    if (xs.nruns == 0) {
+        stats_begin(STATS_RENDER);
+        render_entries(&rs, table.items, table.count);
+        stats_end(STATS_RENDER);
+        if (snap && status == 0 && snapshot_save(snap, table.items, table.count) == -1)
+            perror("snapshot");
+    } else {
+        stats_begin(STATS_SORT);
+        rc = table.count > 0 ? extsort_spill(&xs, table.items, table.count) : 0;
+        stats_end(STATS_SORT);
+        if (rc == -1) {
+            perror("spill");
+            status = -1;
+            goto out;
+        }
+        entry_table_free(&table);
+        stats_begin(STATS_RENDER);
+        rc = extsort_merge(&xs, render_one, &rs);
+        stats_end(STATS_RENDER);
+        if (rc == -1) {
+            perror("merge");
+            status = -1;
+            goto out;
+        }
+    }
+    render_finish(&rs);
+
+out:
+    extsort_free(&xs);
+    entry_table_free(&table);
+    return status;
+}
+
+// Render in directory order, STREAM_BATCH entries at a time, so
+// memory stays bounded and output starts after the first batch.
+static int list_streaming(const struct ls_options *opt, struct dirscan *ds, struct outbuf *out,
+                          struct walk_node *node) {
+    struct dirscan_entry de;
+    struct entry_table batch;
+    struct render_state rs;
+    int rc;
+
+    entry_table_init(&batch);
+    render_init(&rs, opt, out, node);
+
+    do {
+        stats_begin(STATS_SCAN);
+        while (batch.count < STREAM_BATCH &&
+               (!opt->limit || rs.r.shown + batch.count < opt->limit) &&
+               (rc = dirscan_next(ds, &de)) == 1) {
+            if (lsv_skip_entry(&opt->lsv, &de)) continue;
+            if (!entry_table_add(&batch, &de)) {
+                perror("malloc");
+                stats_end(STATS_SCAN);
+                entry_table_free(&batch);
+                return -1;
+            }
+        }
+        stats_end(STATS_SCAN);
+
+        lsv_fetch_metadata(&opt->lsv, ds->fd, batch.items, batch.count);
+        stats_begin(STATS_RENDER);
+        render_entries(&rs, batch.items, batch.count);
+        stats_end(STATS_RENDER);
+        out_flush(out);
+
+        entry_table_clear(&batch);
+    } while (rc == 1 && !out->error && (!opt->limit || rs.r.shown < opt->limit));
+
+    if (rc == -1)
+        perror("getdents64");
+    render_finish(&rs);
+
+    entry_table_free(&batch);
+    return rc == -1 ? -1 : 0;
+}
+
+// --limit: keep the first N entries of the listing order in a
+// bounded heap as the scan goes.  In name order an entry that cannot
+// make the cut is dropped before it is copied or stat'ed, and only
+// the N kept entries are stat'ed at the end.  -t and -S need the key
+// first, so candidates are stat'ed in STREAM_BATCH groups and then
+// offered.  Memory stays O(N + STREAM_BATCH) either way.
+static int list_limited(const struct ls_options *opt, struct dirscan *ds, struct outbuf *out,
+                        struct walk_node *node) {
+    struct dirscan_entry de;
+    struct entry_table batch;
+    struct topn top;
+    struct render_state rs;
+    int by_name = opt->lsv.sort.field == SORT_NAME;
+    int rc, failed = 0;
+
+    entry_table_init(&batch);
+    topn_init(&top, opt->limit, sort_compare, &opt->lsv.sort);
+
+    do {
+        stats_begin(STATS_SCAN);
+        while (batch.count < STREAM_BATCH && (rc = dirscan_next(ds, &de)) == 1) {
+            if (lsv_skip_entry(&opt->lsv, &de)) continue;
+            if (by_name) {
+                struct entry probe = {
+                    .name = de.name, .namelen = (uint16_t)de.namelen,
+                    .d_type = de.type, .ino = de.ino,
+                };
+                failed |= topn_offer(&top, &probe);
+            } else if (!entry_table_add(&batch, &de)) {
+                failed = -1;
+                break;
+            }
+        }
+        stats_end(STATS_SCAN);
+
+        lsv_fetch_metadata(&opt->lsv, ds->fd, batch.items, batch.count);
+        stats_begin(STATS_SORT);
+        for (int i = 0; i < batch.count; i++)
+            failed |= topn_offer(&top, &batch.items[i]);
+        stats_end(STATS_SORT);
+        stats_max(STATS_TABLE_PEAK, entry_table_bytes(&batch) + topn_bytes(&top));
+        entry_table_clear(&batch);
+    } while (rc == 1 && !failed);
+
+    if (failed)
+        perror("malloc");
+    else if (rc == -1)
+        perror("getdents64");
+
+    int count;
+    struct entry *kept = topn_finish(&top, &count);
+    if (by_name)
+        lsv_fetch_metadata(&opt->lsv, ds->fd, kept, count);
+
+    render_init(&rs, opt, out, node);
+    stats_begin(STATS_RENDER);
+    render_entries(&rs, kept, count);
+    stats_end(STATS_RENDER);
+    render_finish(&rs);
+
+    topn_free(&top);
+    entry_table_free(&batch);
+    return failed || rc == -1 ? -1 : 0;
 }
 
 // ==============================
-// Helper: Determine and print colorized filename
+// Recursive and multi-operand listing
 // ==============================
-void print_colorized_name(const char *dirpath, const char *filename) {
-    char filepath[1024];
-    struct stat fileStat;
 
-    snprintf(filepath, sizeof(filepath), "%s/%s", dirpath, filename);
+// One directory's listing, rendered by a walker thread
+struct dir_block {
+    struct outbuf out;       // memory writer
+    int error;               // errno from opening the directory
+    int failed;              // the listing is incomplete
+};
+
+struct walk_ctx {
+    const struct ls_options *opt;    // per-directory options (jobs = 1)
+    struct outbuf *out;              // real output
+    int emitted;                     // blocks printed so far
+    int status;
+};
+
+// List one directory.  With --cache, a sorted listing whose snapshot
+// is still current is rendered from it without reading the directory.
+// Returns -1 if the listing failed; *error is set if path could not
+// be opened at all.
+static int list_dir(const struct ls_options *opt, int *error, struct outbuf *out,
+                    const char *path, struct walk_node *node) {
+    struct dirscan ds;
+    struct snapshot snap, *cached = NULL;
+    int status;
+
+    if (dirscan_open(&ds, path, NULL, DIRSCAN_DEFAULT_BUFSIZE) == -1) {
+        *error = errno;
+        return -1;
+    }
+
+    if (opt->cache_dir && !opt->lsv.unsorted && !opt->mem_limit && !opt->limit) {
+        int hit = snapshot_open(&snap, opt->cache_dir, ds.fd, opt->cache_key);
+        if (hit == 1) {
+            struct render_state rs;
+            render_init(&rs, opt, out, node);
+            stats_begin(STATS_RENDER);
+            render_entries(&rs, snap.entries, snap.count);
+            stats_end(STATS_RENDER);
+            render_finish(&rs);
+            snapshot_release(&snap);
+            dirscan_close(&ds);
+            return 0;
+        }
+        if (hit == 0)
+            cached = &snap;
+    }
+
+    if (opt->lsv.unsorted)
+        status = list_streaming(opt, &ds, out, node);
+    else if (opt->limit)
+        status = list_limited(opt, &ds, out, node);
+    else
+        status = list_sorted(opt, &ds, out, node, cached);
+    dirscan_close(&ds);
+    return status;
+}
+
+static void walk_process(struct walk_node *node, void *arg) {
+    struct walk_ctx *ctx = arg;
+    struct dir_block *block = calloc(1, sizeof(*block));
+
+    if (!block || out_init_mem(&block->out, 4096) == -1) {
+        free(block);
+        node->result = NULL;
+        return;
+    }
+    block->failed = list_dir(ctx->opt, &block->error, &block->out, node->path, node) == -1;
+    node->result = block;
+}
+
+// Blocks arrive in operand order (serial ls -R order with -R):
+// "path:", the listing, and a blank line between consecutive blocks
+static void walk_emit(struct walk_node *node, void *arg) {
+    struct walk_ctx *ctx = arg;
+    struct dir_block *block = node->result;
+
+    if (ctx->opt->lsv.format == FORMAT_TEXT) {
+        if (ctx->emitted++)
+            out_char(ctx->out, '\n');
+        out_puts(ctx->out, node->path);
+        out_write(ctx->out, ":\n", 2);
+    }
 
-    // Use lstat to detect symbolic links correctly
-    if (lstat(filepath, &fileStat) == -1) {
-        perror("lstat");
-        printf("%s\n", filename);
+    if (!block) {
+        fprintf(stderr, "%s: %s\n", node->path, strerror(ENOMEM));
+        ctx->status = 1;
         return;
     }
+    if (block->error) {
+        out_flush(ctx->out);
+        fprintf(stderr, "cannot open directory '%s': %s\n", node->path, strerror(block->error));
+        ctx->status = 1;
+    } else {
+        out_write(ctx->out, block->out.buf, block->out.len);
+        if (block->failed)
+            ctx->status = 1;
+    }
+    out_close(&block->out);
+    free(block);
+}
+
+// List directories on the walker's threads, each block printed as
+// soon as it and every block before it are done.  emitted is the
+// number of blocks already printed (the file operands).
+static int list_dirs(const struct ls_options *opt, const char *const *dirs, int ndirs,
+                     int threads, int emitted, struct outbuf *out) {
+    struct ls_options dir_opt = *opt;
+    dir_opt.lsv.jobs = 1;        // parallelism comes from the walker
+
+    struct walk_ctx ctx = { .opt = &dir_opt, .out = out, .emitted = emitted };
+    if (walk_run(dirs, ndirs, threads, walk_process, walk_emit, &ctx) == -1) {
+        perror("walk");
+        return -1;
+    }
+    return ctx.status ? -1 : 0;
+}
+
+// Operands that are not directories are listed first, as one block
+// sorted like directory entries and shown under the name given
+static void list_files(const struct ls_options *opt, struct entry_table *files,
+                       struct outbuf *out) {
+    struct render_state rs;
+
+    lsv_fetch_metadata(&opt->lsv, AT_FDCWD, files->items, files->count);
+    sort_entries(&opt->lsv.sort, files->items, files->count);
+    render_init(&rs, opt, out, NULL);
+    render_entries(&rs, files->items, files->count);
+    render_finish(&rs);
+}
+
+// Like ls, symlinks given as operands are followed to decide whether
+// they are directories, except with -l
+static int list_operands(const struct ls_options *opt, const char *const *operands, int n,
+                         int threads, struct outbuf *out) {
+    struct entry_table files;
+    const char **dirs = malloc(n * sizeof(*dirs));
+    int ndirs = 0, status = 0;
+
+    if (!dirs) {
+        perror("malloc");
+        return -1;
+    }
+    entry_table_init(&files);
 
-    const char *color = COLOR_RESET;
+    for (int i = 0; i < n; i++) {
+        struct stat st;
+        int rc = opt->lsv.long_flag ? lstat(operands[i], &st) : stat(operands[i], &st);
+        if (rc == -1 && !opt->lsv.long_flag && errno == ENOENT)
+            rc = lstat(operands[i], &st);            // dangling symlink
+        if (rc == -1) {
+            out_flush(out);
+            fprintf(stderr, "cannot access '%s': %s\n", operands[i], strerror(errno));
+            status = -1;
+            continue;
+        }
+        if (S_ISDIR(st.st_mode)) {
+            dirs[ndirs++] = operands[i];
+            continue;
+        }
 
-    // Determine color based on file type
-    if (S_ISDIR(fileStat.st_mode)) {
-        color = COLOR_BLUE;
-    } else if (S_ISLNK(fileStat.st_mode)) {
-        color = COLOR_PINK;
-    } else if (S_ISCHR(fileStat.st_mode) || S_ISBLK(fileStat.st_mode) ||
-               S_ISSOCK(fileStat.st_mode) || S_ISFIFO(fileStat.st_mode)) {
-        color = COLOR_REVERSE;
-    } else if (fileStat.st_mode & S_IXUSR) {
-        color = COLOR_GREEN;
-    } else if (strstr(filename, ".tar") || strstr(filename, ".gz") || strstr(filename, ".zip")) {
-        color = COLOR_RED;
+        struct dirscan_entry de = {
+            .ino = st.st_ino, .type = DT_UNKNOWN,
+            .namelen = strlen(operands[i]), .name = operands[i],
+        };
+        if (!entry_table_add(&files, &de)) {
+            perror("malloc");
+            status = -1;
+        }
+    }
+
+    if (files.count > 0)
+        list_files(opt, &files, out);
+
+    // A lone directory is listed without a header, on this thread
+    if (ndirs == 1 && n == 1 && !opt->recursive) {
+        int error = 0;
+        if (list_dir(opt, &error, out, dirs[0], NULL) == -1) {
+            if (error) {
+                errno = error;
+                perror("opendir");
+            }
+            status = -1;
+        }
+    } else if (ndirs > 0 && list_dirs(opt, dirs, ndirs, threads, files.count > 0, out) == -1) {
+        status = -1;
     }
 
-    printf("%s%s%s", color, filename, COLOR_RESET);
+    entry_table_free(&files);
+    free(dirs);
+    return status;
 }
 
 // ==============================
-// Display functions
+// Watch mode (--watch)
 // ==============================
 
-// Horizontal display (-x)
-void print_horizontal_listing(const char *dirpath, char **filenames, int count) {
-    for (int i = 0; i < count; i++) {
-        print_colorized_name(dirpath, filenames[i]);
-        printf("%-20s", "");
-        if ((i + 1) % 5 == 0)
-            printf("\n");
+// Bytes of inotify events read per batch
+#define WATCH_EVENT_BUF (64 * 1024)
+
+// While the directory is held open its removal raises no inotify
+// event, so an idle watch checks the link count this often
+#define WATCH_IDLE_MS 1000
+
+#define WATCH_MASK (IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_ATTRIB | \
+                    IN_MODIFY | IN_CLOSE_WRITE | IN_DELETE_SELF | IN_MOVE_SELF)
+
+struct watch_state {
+    const struct ls_options *opt;
+    struct outbuf *out;
+    struct timefmt tf;
+    int dirfd;
+    unsigned want;
+    struct entry_set set;
+};
+
+// Entries touched by one batch of events, grouped by kind
+struct watch_changes {
+    struct entry *items;
+    int count;
+    int capacity;
+};
+
+static int watch_push(struct watch_changes *c, const struct entry *e) {
+    if (c->count == c->capacity) {
+        int capacity = c->capacity ? c->capacity * 2 : 16;
+        struct entry *items = realloc(c->items, capacity * sizeof(*items));
+        if (!items)
+            return -1;
+        c->items = items;
+        c->capacity = capacity;
     }
-    printf("\n");
+    c->items[c->count++] = *e;
+    return 0;
 }
 
-// Long display (-l)
-void print_long_listing(const char *dirpath, char **filenames, int count) {
-    struct stat fileStat;
-    char filepath[1024];
+// Compare only the wanted fields both sides have: a plain listing's
+// set holds d_type metadata, which carries the file type alone
+static int same_meta(const struct file_meta *a, const struct file_meta *b, unsigned want) {
+    unsigned both = a->valid & b->valid & want;
+    if (a->error != b->error || ((a->mode ^ b->mode) & S_IFMT))
+        return 0;
+    if ((both & META_MODE) && a->mode != b->mode) return 0;
+    if ((both & META_NLINK) && a->nlink != b->nlink) return 0;
+    if ((both & META_UID) && a->uid != b->uid) return 0;
+    if ((both & META_GID) && a->gid != b->gid) return 0;
+    if ((both & META_SIZE) && a->size != b->size) return 0;
+    if ((both & META_INO) && a->ino != b->ino) return 0;
+    return !(both & META_MTIME) || (a->mtime.tv_sec == b->mtime.tv_sec &&
+                                    a->mtime.tv_nsec == b->mtime.tv_nsec);
+}
 
-    for (int i = 0; i < count; i++) {
-        snprintf(filepath, sizeof(filepath), "%s/%s", dirpath, filenames[i]);
-        if (stat(filepath, &fileStat) == 0) {
-            print_colorized_name(dirpath, filenames[i]);
-            printf("  %lld bytes\n", (long long)fileStat.st_size);
+// Scan the whole directory into the set and print it in full
+static int watch_load(struct watch_state *ws, struct dirscan *ds) {
+    const struct ls_options *opt = ws->opt;
+    struct dirscan_entry de;
+    struct entry_table table;
+    struct render_state rs;
+    int rc;
+
+    entry_table_init(&table);
+    while ((rc = dirscan_next(ds, &de)) == 1) {
+        if (lsv_skip_entry(&opt->lsv, &de)) continue;
+        if (!entry_table_add(&table, &de)) {
+            perror("malloc");
+            entry_table_free(&table);
+            return -1;
+        }
+    }
+    if (rc == -1) {
+        perror("getdents64");
+        entry_table_free(&table);
+        return -1;
+    }
+
+    lsv_fetch_metadata(&opt->lsv, ds->fd, table.items, table.count);
+    sort_entries(&opt->lsv.sort, table.items, table.count);
+    render_init(&rs, opt, ws->out, NULL);
+    render_entries(&rs, table.items, table.count);
+    render_finish(&rs);
+    out_flush(ws->out);
+
+    return entry_set_init(&ws->set, &table);
+}
+
+static void watch_print(struct watch_state *ws, char marker, struct watch_changes *c) {
+    sort_entries(&ws->opt->lsv.sort, c->items, c->count);
+    for (int i = 0; i < c->count; i++) {
+        // -l gives an entry whose lookup failed no row (on_error
+        // reports it instead), so it gets no marker either
+        if (!ws->opt->lsv.long_flag || !c->items[i].meta.error) {
+            out_char(ws->out, marker);
+            out_char(ws->out, ' ');
         }
+        if (ws->opt->lsv.long_flag)
+            lsv_print_long_listing(ws->out, &ws->tf, &ws->opt->lsv, &c->items[i], 1);
+        else
+            lsv_print_vertical_listing(ws->out, &c->items[i], 1);
     }
 }
 
-// Default (vertical) display
-void print_vertical_listing(const char *dirpath, char **filenames, int count) {
-    for (int i = 0; i < count; i++) {
-        print_colorized_name(dirpath, filenames[i]);
-        printf("\n");
+static int dir_unlinked(int dirfd) {
+    struct stat st;
+    return fstat(dirfd, &st) == 0 && st.st_nlink == 0;
+}
+
+static int compare_cstrings(const void *a, const void *b) {
+    return strcmp(*(const char *const *)a, *(const char *const *)b);
+}
+
+// Re-stat only the names events mentioned and print what changed:
+// "- " removed, "~ " changed, "+ " added, each group in listing order
+static void watch_apply(struct watch_state *ws, const char **names, int n) {
+    struct watch_changes removed = { 0 }, changed = { 0 }, added = { 0 };
+    int failed = 0;
+
+    qsort(names, n, sizeof(*names), compare_cstrings);
+    for (int i = 0; i < n; i++) {
+        if (i > 0 && strcmp(names[i], names[i - 1]) == 0)
+            continue;
+        struct dirscan_entry de = { .namelen = strlen(names[i]), .name = names[i] };
+        if (lsv_skip_entry(&ws->opt->lsv, &de))
+            continue;
+
+        struct file_meta m;
+        int rc = meta_fetch(ws->dirfd, names[i], ws->want, &m);
+        struct entry *e = entry_set_find(&ws->set, names[i], de.namelen);
+
+        if (rc == -1 && errno == ENOENT) {
+            if (e) {
+                failed |= watch_push(&removed, e);
+                entry_set_remove(&ws->set, e);
+            }
+            continue;
+        }
+        if (rc == -1) {
+            m.valid = 0;
+            m.error = errno;
+        }
+
+        if (!e) {
+            de.ino = m.ino;
+            de.type = m.error ? DT_UNKNOWN : IFTODT(m.mode);
+            e = entry_set_add(&ws->set, &de, &m);
+            failed |= !e || watch_push(&added, e);
+        } else if (!same_meta(&e->meta, &m, ws->want)) {
+            e->meta = m;
+            failed |= watch_push(&changed, e);
+        }
     }
+    if (failed)
+        perror("watch");
+
+    watch_print(ws, '-', &removed);
+    watch_print(ws, '~', &changed);
+    watch_print(ws, '+', &added);
+    out_flush(ws->out);
+
+    // Removed names stay readable until here
+    if (entry_set_compact(&ws->set) == -1)
+        perror("watch");
+    free(removed.items);
+    free(changed.items);
+    free(added.items);
+}
+
+// List path once, then follow it with inotify: each batch of events
+// costs a stat per name mentioned, independent of the directory size.
+// Runs until the directory goes away or output fails.
+static int watch_dir(const struct ls_options *opt, const char *path, struct outbuf *out) {
+    struct watch_state ws = { .opt = opt, .out = out };
+    struct dirscan ds;
+    int status = 0;
+
+    int ifd = inotify_init1(IN_CLOEXEC);
+    if (ifd == -1) {
+        perror("inotify_init1");
+        return -1;
+    }
+    // Subscribe before the scan so no change in between is missed
+    if (inotify_add_watch(ifd, path, WATCH_MASK | IN_ONLYDIR) == -1 ||
+        dirscan_open(&ds, path, NULL, DIRSCAN_DEFAULT_BUFSIZE) == -1) {
+        perror(path);
+        close(ifd);
+        return -1;
+    }
+
+    ws.dirfd = ds.fd;
+    ws.want = lsv_wanted_fields(&opt->lsv) | META_INO;
+    timefmt_init(&ws.tf);
+
+    size_t max_names = WATCH_EVENT_BUF / sizeof(struct inotify_event) + 1;
+    char *buf = malloc(WATCH_EVENT_BUF);
+    const char **names = malloc(max_names * sizeof(*names));
+    if (!buf || !names || watch_load(&ws, &ds) == -1) {
+        perror("watch");
+        free(buf);
+        free(names);
+        dirscan_close(&ds);
+        close(ifd);
+        return -1;
+    }
+
+    while (!out->error) {
+        struct pollfd pfd = { .fd = ifd, .events = POLLIN };
+        int ready = poll(&pfd, 1, WATCH_IDLE_MS);
+        if (ready == 0 && dir_unlinked(ds.fd)) {
+            fprintf(stderr, "%s: directory removed or moved, stopping\n", path);
+            break;
+        }
+        if (ready <= 0)
+            continue;
+
+        ssize_t len = read(ifd, buf, WATCH_EVENT_BUF);
+        if (len == -1) {
+            if (errno == EINTR)
+                continue;
+            perror("inotify");
+            status = -1;
+            break;
+        }
+
+        int n = 0, overflow = 0, gone = 0;
+        for (char *p = buf; p < buf + len;) {
+            struct inotify_event *ev = (struct inotify_event *)p;
+            if (ev->mask & IN_Q_OVERFLOW)
+                overflow = 1;
+            if (ev->mask & (IN_DELETE_SELF | IN_MOVE_SELF | IN_IGNORED))
+                gone = 1;
+            if (ev->len > 0 && ev->name[0])
+                names[n++] = ev->name;
+            p += sizeof(*ev) + ev->len;
+        }
+
+        if (overflow) {
+            // Events were lost: start over from a full listing
+            entry_set_free(&ws.set);
+            out_char(out, '\n');
+            if (dirscan_rewind(&ds) == -1 || watch_load(&ws, &ds) == -1) {
+                perror("watch");
+                status = -1;
+                break;
+            }
+        } else {
+            watch_apply(&ws, names, n);
+        }
+
+        if (gone) {
+            fprintf(stderr, "%s: directory removed or moved, stopping\n", path);
+            break;
+        }
+    }
+
+    entry_set_free(&ws.set);
+    free(buf);
+    free(names);
+    dirscan_close(&ds);
+    close(ifd);
+    return status;
+}
+
+// Snapshots are only reused by runs that would build the same
+// table: same entries, metadata fields, order and collation locale.
+// -R is part of it: machine formats only stat DT_UNKNOWN entries to
+// find the directories to descend into.
+static uint64_t hash_string(uint64_t h, const char *s) {
+    for (const char *p = s; p && *p; p++)
+        h = (h ^ (unsigned char)*p) * 1099511628211ULL;
+    return (h ^ 0xff) * 1099511628211ULL;      // terminator
+}
+
+static uint64_t options_key(const struct ls_options *opt) {
+    uint64_t h = 14695981039346656037ULL;        // FNV-1a
+    unsigned char fields[] = {
+        (unsigned char)lsv_wanted_fields(&opt->lsv), (unsigned char)opt->lsv.show_all,
+        (unsigned char)opt->lsv.sort.field, (unsigned char)opt->lsv.sort.reverse,
+        (unsigned char)opt->lsv.sort.collate, (unsigned char)opt->lsv.no_stat,
+        (unsigned char)opt->lsv.format, (unsigned char)opt->lsv.find_dirs,
+        (unsigned char)colors_need_mode(DT_REG), (unsigned char)colors_need_mode(DT_DIR),
+    };
+    for (size_t i = 0; i < sizeof(fields); i++)
+        h = (h ^ fields[i]) * 1099511628211ULL;
+    if (opt->lsv.sort.collate)
+        h = hash_string(h, setlocale(LC_COLLATE, NULL));
+    if (opt->lsv.glob || opt->regex_text) {
+        h = hash_string(h, opt->lsv.glob);
+        h = hash_string(h, opt->regex_text);
+    }
+    return h;
+}
+
+// -l rows whose lookup failed are skipped; say why on stderr
+static void report_meta_error(const char *name, int err, void *arg) {
+    (void)arg;
+    fprintf(stderr, "%s: %s\n", name, strerror(err));
+}
+
+// Parse a size such as 65536, 512K, 64M or 2G
+static int parse_size(const char *s, size_t *out) {
+    char *end;
+    unsigned long long v = strtoull(s, &end, 10);
+    if (end == s)
+        return -1;
+    switch (*end) {
+    case 'k': case 'K': v <<= 10; end++; break;
+    case 'm': case 'M': v <<= 20; end++; break;
+    case 'g': case 'G': v <<= 30; end++; break;
+    }
+    if (*end != '\0')
+        return -1;
+    *out = (size_t)v;
+    return 0;
 }
 
 // ==============================
 // Main program
 // ==============================
 int main(int argc, char *argv[]) {
-    const char *dirpath = ".";
-    int long_flag = 0, horiz_flag = 0;
+    const char **operands = malloc(argc * sizeof(*operands));
+    int noperands = 0;
+    if (!operands) {
+        perror("malloc");
+        return 1;
+    }
+    struct ls_options opt = { .lsv.jobs = 1, .lsv.on_error = report_meta_error };
+    int jobs_given = 0;
+    int use_cache = 0;
+    int show_stats = 0;
+    int watch = 0;
+    int mode_colors = 0;
+    char *cache_dir = NULL;
 
     // Parse flags
     for (int i = 1; i < argc; i++) {
-        if (strcmp(argv[i], "-l") == 0) long_flag = 1;
-        else if (strcmp(argv[i], "-x") == 0) horiz_flag = 1;
-        else dirpath = argv[i];
+        if (strcmp(argv[i], "-l") == 0) opt.lsv.long_flag = 1;
+        else if (strcmp(argv[i], "-x") == 0) opt.lsv.horiz_flag = 1;
+        else if (strcmp(argv[i], "-t") == 0) opt.lsv.sort.field = SORT_MTIME;
+        else if (strcmp(argv[i], "-S") == 0) opt.lsv.sort.field = SORT_SIZE;
+        else if (strcmp(argv[i], "-r") == 0) opt.lsv.sort.reverse = 1;
+        else if (strcmp(argv[i], "-R") == 0) opt.recursive = opt.lsv.find_dirs = 1;
+        else if (strcmp(argv[i], "-U") == 0) opt.lsv.unsorted = 1;
+        else if (strcmp(argv[i], "-f") == 0) opt.lsv.unsorted = opt.lsv.show_all = 1;
+        else if (strncmp(argv[i], "--jobs=", 7) == 0) {
+            opt.lsv.jobs = atoi(argv[i] + 7);
+            jobs_given = 1;
+            if (opt.lsv.jobs < 1 || opt.lsv.jobs > STATPOOL_MAX_JOBS) {
+                fprintf(stderr, "Invalid --jobs value: %s (1-%d)\n", argv[i] + 7, STATPOOL_MAX_JOBS);
+                return 1;
+            }
+        }
+        else if (strncmp(argv[i], "--mem-limit=", 12) == 0) {
+            if (parse_size(argv[i] + 12, &opt.mem_limit) == -1 || opt.mem_limit < MIN_MEM_LIMIT) {
+                fprintf(stderr, "Invalid --mem-limit value: %s (at least 64K)\n", argv[i] + 12);
+                return 1;
+            }
+        }
+        else if (strcmp(argv[i], "--local-ids") == 0) opt.local_ids = 1;
+        else if (strcmp(argv[i], "--no-stat") == 0) opt.lsv.no_stat = 1;
+        else if (strcmp(argv[i], "--mode-colors") == 0) mode_colors = 1;
+        else if (strcmp(argv[i], "--stats") == 0) show_stats = 1;
+        else if (strcmp(argv[i], "--watch") == 0) watch = 1;
+        else if (strcmp(argv[i], "--format=nul") == 0) opt.lsv.format = FORMAT_NUL;
+        else if (strcmp(argv[i], "--format=jsonl") == 0) opt.lsv.format = FORMAT_JSONL;
+        else if (strcmp(argv[i], "--format=binary") == 0) opt.lsv.format = FORMAT_BINARY;
+        else if (strncmp(argv[i], "--format=", 9) == 0) {
+            fprintf(stderr, "Unknown format: %s (nul, jsonl, binary)\n", argv[i] + 9);
+            return 1;
+        }
+        else if (strcmp(argv[i], "--cache") == 0) use_cache = 1;
+        else if (strncmp(argv[i], "--cache=", 8) == 0) {
+            opt.cache_dir = argv[i] + 8;
+            use_cache = 1;
+        }
+        else if (strcmp(argv[i], "--collate") == 0) opt.lsv.sort.collate = 1;
+        else if (strncmp(argv[i], "--glob=", 7) == 0) opt.lsv.glob = argv[i] + 7;
+        else if (strncmp(argv[i], "--regex=", 8) == 0) opt.regex_text = argv[i] + 8;
+        else if (strncmp(argv[i], "--limit=", 8) == 0) {
+            char *end;
+            long v = strtol(argv[i] + 8, &end, 10);
+            if (end == argv[i] + 8 || *end || v < 1 || v > INT_MAX) {
+                fprintf(stderr, "Invalid --limit value: %s\n", argv[i] + 8);
+                return 1;
+            }
+            opt.limit = (int)v;
+        }
+        else if (strcmp(argv[i], "--meta=sync") == 0) opt.lsv.use_uring = 0;
+        else if (strcmp(argv[i], "--meta=uring") == 0) opt.lsv.use_uring = 1;
+        else if (strncmp(argv[i], "--meta=", 7) == 0) {
+            fprintf(stderr, "Unknown metadata backend: %s (sync, uring)\n", argv[i] + 7);
+            return 1;
+        }
+        else operands[noperands++] = argv[i];
+    }
+    if (noperands == 0)
+        operands[noperands++] = ".";
+
+    // Locale order only matters outside the C locale, where it is
+    // identical to the plain byte order.  LC_CTYPE decides which
+    // names are valid multibyte strings.
+    if (opt.lsv.sort.collate) {
+        setlocale(LC_CTYPE, "");
+        const char *loc = setlocale(LC_COLLATE, "");
+        if (!loc || strcmp(loc, "C") == 0 || strcmp(loc, "POSIX") == 0)
+            opt.lsv.sort.collate = 0;
     }
 
-    DIR *dir = opendir(dirpath);
-    if (!dir) {
-        perror("opendir");
+    if (watch && (noperands != 1 || opt.recursive || opt.lsv.unsorted || opt.mem_limit ||
+                  opt.limit || opt.lsv.format != FORMAT_TEXT)) {
+        fprintf(stderr, "--watch takes one directory and cannot be combined with -R, -U, -f, "
+                        "--mem-limit, --limit or --format\n");
         return 1;
     }
 
-    struct dirent *entry;
-    char **filenames = NULL;
-    int count = 0;
+    // Name filters run inside the scan loops, before any copy or stat
+    regex_t regex;
+    if (opt.regex_text) {
+        int rc = regcomp(&regex, opt.regex_text, REG_EXTENDED | REG_NOSUB);
+        if (rc != 0) {
+            char msg[256];
+            regerror(rc, &regex, msg, sizeof(msg));
+            fprintf(stderr, "Invalid --regex: %s\n", msg);
+            return 1;
+        }
+        opt.lsv.regex = &regex;
+    }
+
+    if (show_stats)
+        stats_enable();
 
-    // Read all entries
-    while ((entry = readdir(dir)) != NULL) {
-        if (entry->d_name[0] == '.') continue; // skip hidden files
-        filenames = realloc(filenames, (count + 1) * sizeof(char *));
-        filenames[count] = strdup(entry->d_name);
-        count++;
+    if (lsv_init(getenv("LS_COLORS"), mode_colors) == -1)
+        perror("LS_COLORS");
+
+    if (opt.lsv.no_stat && (lsv_wanted_fields(&opt.lsv) & ~(META_TYPE | META_MODE))) {
+        fprintf(stderr, "--no-stat cannot be combined with -l, -t, -S or --format=jsonl|binary\n");
+        return 1;
     }
-    closedir(dir);
 
-    // Sort filenames alphabetically
-    qsort(filenames, count, sizeof(char *), compare_names);
+    // Resolve owners from /etc/passwd and /etc/group only, skipping NSS
+    if (opt.local_ids && idcache_preload() == -1)
+        perror("idcache_preload");
 
-    // Choose display mode
-    if (long_flag)
-        print_long_listing(dirpath, filenames, count);
-    else if (horiz_flag)
-        print_horizontal_listing(dirpath, filenames, count);
+    // Listing snapshots; the cache is an optimisation, so a missing
+    // or unusable cache directory only costs the speed-up
+    if (use_cache) {
+        if (!opt.cache_dir)
+            opt.cache_dir = cache_dir = snapshot_default_dir();
+        if (!opt.cache_dir || snapshot_mkdir(opt.cache_dir) == -1) {
+            if (opt.cache_dir)
+                perror("cache");
+            opt.cache_dir = NULL;
+        }
+        opt.cache_key = options_key(&opt);
+    }
+
+    // All listing output goes through one buffered writer; stdio is
+    // left for diagnostics only, so its locking is switched off
+    // (stderr keeps it when walker threads may report errors).
+    __fsetlocking(stdout, FSETLOCKING_BYCALLER);
+    if (!opt.recursive && noperands == 1)
+        __fsetlocking(stderr, FSETLOCKING_BYCALLER);
+
+    struct outbuf out;
+    if (out_init(&out, STDOUT_FILENO, OUTBUF_DEFAULT_SIZE) == -1) {
+        perror("malloc");
+        return 1;
+    }
+
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    int threads = jobs_given ? opt.lsv.jobs : (cpus > 0 ? (int)cpus : 1);
+    if (threads > WALK_MAX_THREADS) threads = WALK_MAX_THREADS;
+    format_begin(opt.lsv.format, &out);
+    int status;
+    if (watch)
+        status = watch_dir(&opt, operands[0], &out) == -1;
     else
-        print_vertical_listing(dirpath, filenames, count);
+        status = list_operands(&opt, operands, noperands, threads, &out) == -1;
 
-    // Free memory
-    for (int i = 0; i < count; i++)
-        free(filenames[i]);
-    free(filenames);
+    if (out_close(&out) == -1) {
+        errno = out.error;
+        perror("write");
+        status = 1;
+    }
 
-    return 0;
+    if (show_stats)
+        stats_report(stderr);
+
+    if (opt.lsv.regex)
+        regfree(&regex);
+    free(cache_dir);
+    free(operands);
+    return status;
 }
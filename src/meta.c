@@ -0,0 +1,92 @@
+#define _GNU_SOURCE
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <sys/stat.h>
+
+#include "meta.h"
+#include "stats.h"
+
+#ifdef STATX_BASIC_STATS
+// Translate META_* bits into the smallest STATX_* request mask
+unsigned int meta_statx_mask(unsigned want) {
+    unsigned int mask = STATX_TYPE;
+    if (want & META_MODE)  mask |= STATX_MODE;
+    if (want & META_NLINK) mask |= STATX_NLINK;
+    if (want & META_UID)   mask |= STATX_UID;
+    if (want & META_GID)   mask |= STATX_GID;
+    if (want & META_SIZE)  mask |= STATX_SIZE;
+    if (want & META_MTIME) mask |= STATX_MTIME;
+    if (want & META_INO)   mask |= STATX_INO;
+    return mask;
+}
+
+void meta_from_statx(const struct statx *stx, struct file_meta *m) {
+    unsigned int got = stx->stx_mask;
+    m->mode = stx->stx_mode;
+    if (got & STATX_TYPE)  m->valid |= META_TYPE;
+    if (got & STATX_MODE)  m->valid |= META_MODE;
+    if (got & STATX_NLINK) { m->nlink = stx->stx_nlink; m->valid |= META_NLINK; }
+    if (got & STATX_UID)   { m->uid = stx->stx_uid; m->valid |= META_UID; }
+    if (got & STATX_GID)   { m->gid = stx->stx_gid; m->valid |= META_GID; }
+    if (got & STATX_SIZE)  { m->size = (off_t)stx->stx_size; m->valid |= META_SIZE; }
+    if (got & STATX_INO)   { m->ino = (ino_t)stx->stx_ino; m->valid |= META_INO; }
+    if (got & STATX_MTIME) {
+        m->mtime.tv_sec = stx->stx_mtime.tv_sec;
+        m->mtime.tv_nsec = stx->stx_mtime.tv_nsec;
+        m->valid |= META_MTIME;
+    }
+}
+
+// Set once the kernel reports ENOSYS; stat-pool and walker threads
+// share it, so it is only touched atomically
+static int statx_unsupported;
+#endif
+
+static void meta_from_stat(const struct stat *st, struct file_meta *m) {
+    m->valid = META_TYPE | META_MODE | META_NLINK | META_UID | META_GID |
+               META_SIZE | META_MTIME | META_INO;
+    m->mode = st->st_mode;
+    m->nlink = st->st_nlink;
+    m->uid = st->st_uid;
+    m->gid = st->st_gid;
+    m->size = st->st_size;
+    m->ino = st->st_ino;
+    m->mtime = st->st_mtim;
+}
+
+int meta_fetch(int dirfd, const char *name, unsigned want, struct file_meta *m) {
+    memset(m, 0, sizeof(*m));
+    stats_add(STATS_STAT, 1);
+
+#ifdef STATX_BASIC_STATS
+    if (!__atomic_load_n(&statx_unsupported, __ATOMIC_RELAXED)) {
+        struct statx stx;
+        if (statx(dirfd, name, AT_SYMLINK_NOFOLLOW | AT_STATX_SYNC_AS_STAT,
+                  meta_statx_mask(want), &stx) == 0) {
+            meta_from_statx(&stx, m);
+            return 0;
+        }
+        if (errno != ENOSYS)
+            return -1;
+        __atomic_store_n(&statx_unsupported, 1, __ATOMIC_RELAXED);
+    }
+#endif
+
+    // Older kernels/libcs: same dirfd-relative lookup, full struct stat
+    struct stat st;
+    if (fstatat(dirfd, name, &st, AT_SYMLINK_NOFOLLOW) == -1)
+        return -1;
+    meta_from_stat(&st, m);
+    return 0;
+}
+
+int meta_from_dtype(unsigned char d_type, struct file_meta *m) {
+    if (d_type == DT_UNKNOWN)
+        return -1;
+    memset(m, 0, sizeof(*m));
+    m->mode = DTTOIF(d_type);
+    m->valid = META_TYPE;
+    return 0;
+}
@@ -0,0 +1,53 @@
+/* ===========================================================
+ * meta.h - Per-entry metadata fetched relative to a directory fd
+ *
+ * Entries are looked up with statx(dirfd, name, ...) so the kernel
+ * never re-walks the full path, and the request mask only names the
+ * fields the active display actually prints.
+ * =========================================================== */
+#ifndef LSV_META_H
+#define LSV_META_H
+
+#include <sys/types.h>
+#include <time.h>
+
+// Fields a display can ask for
+#define META_TYPE   0x01u
+#define META_MODE   0x02u
+#define META_NLINK  0x04u
+#define META_UID    0x08u
+#define META_GID    0x10u
+#define META_SIZE   0x20u
+#define META_MTIME  0x40u
+#define META_INO    0x80u
+
+// Everything print_long_listing shows
+#define META_LONG   (META_TYPE | META_MODE | META_NLINK | META_UID | \
+                     META_GID | META_SIZE | META_MTIME)
+
+struct file_meta {
+    unsigned valid;          // META_* bits actually filled in
+    mode_t mode;             // file type bits are always present
+    nlink_t nlink;
+    uid_t uid;
+    gid_t gid;
+    off_t size;
+    ino_t ino;
+    struct timespec mtime;
+    int error;               // errno of a failed bulk lookup, else 0
+};
+
+// Fetch metadata for name inside the directory open on dirfd.
+// Symlinks are not followed.  Returns 0 or -1 with errno set.
+int meta_fetch(int dirfd, const char *name, unsigned want, struct file_meta *m);
+
+// Fill in the file type from a dirent d_type, so plain listings can
+// skip the lookup.  Returns 0, or -1 for DT_UNKNOWN (m is untouched).
+int meta_from_dtype(unsigned char d_type, struct file_meta *m);
+
+// Helpers shared with the io_uring backend (uring.c)
+struct statx;
+unsigned int meta_statx_mask(unsigned want);
+void meta_from_statx(const struct statx *stx, struct file_meta *m);
+
+#endif
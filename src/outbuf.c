@@ -0,0 +1,163 @@
+#define _GNU_SOURCE
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/uio.h>
+
+#include "outbuf.h"
+#include "stats.h"
+
+int out_init(struct outbuf *o, int fd, size_t cap) {
+    if (cap == 0)
+        cap = OUTBUF_DEFAULT_SIZE;
+    o->fd = fd;
+    o->cap = cap;
+    o->len = 0;
+    o->written = 0;
+    o->error = 0;
+    o->buf = malloc(cap);
+    return o->buf ? 0 : -1;
+}
+
+// Push iov[] fully, retrying short writes and EINTR
+static int write_all(struct outbuf *o, struct iovec *iov, int iovcnt) {
+    stats_begin(STATS_FLUSH);
+    while (iovcnt > 0) {
+        ssize_t n = writev(o->fd, iov, iovcnt);
+        stats_add(STATS_WRITE, 1);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            o->error = errno;
+            stats_end(STATS_FLUSH);
+            return -1;
+        }
+        o->written += (unsigned long long)n;
+        stats_add(STATS_BYTES, (unsigned long long)n);
+
+        while (iovcnt > 0 && (size_t)n >= iov->iov_len) {
+            n -= (ssize_t)iov->iov_len;
+            iov++;
+            iovcnt--;
+        }
+        if (iovcnt > 0) {
+            iov->iov_base = (char *)iov->iov_base + n;
+            iov->iov_len -= (size_t)n;
+        }
+    }
+    stats_end(STATS_FLUSH);
+    return 0;
+}
+
+int out_init_mem(struct outbuf *o, size_t cap) {
+    return out_init(o, -1, cap);
+}
+
+// Memory writers: make room for at least n more bytes
+static int out_grow(struct outbuf *o, size_t n) {
+    size_t cap = o->cap * 2;
+    while (cap - o->len < n)
+        cap *= 2;
+    char *buf = realloc(o->buf, cap);
+    if (!buf) {
+        o->error = ENOMEM;
+        return -1;
+    }
+    o->buf = buf;
+    o->cap = cap;
+    return 0;
+}
+
+// Called when the buffer is full: write it out, or grow it for a
+// memory writer
+static int out_make_room(struct outbuf *o) {
+    return o->fd < 0 ? out_grow(o, 1) : out_flush(o);
+}
+
+int out_flush(struct outbuf *o) {
+    if (o->error)
+        return -1;
+    if (o->len == 0 || o->fd < 0)
+        return 0;
+
+    struct iovec iov = { o->buf, o->len };
+    o->len = 0;
+    return write_all(o, &iov, 1);
+}
+
+void out_write(struct outbuf *o, const char *s, size_t n) {
+    if (o->error)
+        return;
+    if (n > o->cap - o->len && o->fd < 0 && out_grow(o, n) == -1)
+        return;
+    if (n <= o->cap - o->len) {
+        memcpy(o->buf + o->len, s, n);
+        o->len += n;
+        if (o->len == o->cap)
+            out_make_room(o);
+        return;
+    }
+
+    // Too big for what is left: send buffer and payload in one writev
+    struct iovec iov[2] = {
+        { o->buf, o->len },
+        { (void *)s, n },
+    };
+    o->len = 0;
+    write_all(o, iov, 2);
+}
+
+void out_puts(struct outbuf *o, const char *s) {
+    out_write(o, s, strlen(s));
+}
+
+void out_char(struct outbuf *o, char c) {
+    if (o->len == o->cap && out_make_room(o) == -1)
+        return;
+    o->buf[o->len++] = c;
+}
+
+void out_pad(struct outbuf *o, size_t n) {
+    while (n > 0 && !o->error) {
+        if (o->len == o->cap && out_make_room(o) == -1)
+            return;
+        size_t room = o->cap - o->len;
+        size_t chunk = n < room ? n : room;
+        memset(o->buf + o->len, ' ', chunk);
+        o->len += chunk;
+        n -= chunk;
+    }
+}
+
+void out_str_left(struct outbuf *o, const char *s, size_t width) {
+    size_t n = strlen(s);
+    out_write(o, s, n);
+    if (n < width)
+        out_pad(o, width - n);
+}
+
+void out_num_right(struct outbuf *o, long long v, size_t width) {
+    char digits[24];
+    size_t n = 0;
+    unsigned long long u = v < 0 ? 0ULL - (unsigned long long)v : (unsigned long long)v;
+
+    do {
+        digits[sizeof(digits) - 1 - n++] = (char)('0' + u % 10);
+        u /= 10;
+    } while (u);
+    if (v < 0)
+        digits[sizeof(digits) - 1 - n++] = '-';
+
+    if (n < width)
+        out_pad(o, width - n);
+    out_write(o, digits + sizeof(digits) - n, n);
+}
+
+int out_close(struct outbuf *o) {
+    int rc = out_flush(o);
+    free(o->buf);
+    o->buf = NULL;
+    o->cap = o->len = 0;
+    return rc;
+}
@@ -0,0 +1,52 @@
+/* ===========================================================
+ * outbuf.h - Buffered output writer for every listing mode
+ *
+ * Display code appends into one large user-space buffer; padding
+ * is a memset and numbers are formatted by hand.  The buffer goes
+ * out with write()/writev() once it crosses its size threshold,
+ * so a million-line listing costs a few hundred syscalls and no
+ * stdio locking or format parsing.
+ * =========================================================== */
+#ifndef LSV_OUTBUF_H
+#define LSV_OUTBUF_H
+
+#include <stddef.h>
+
+#define OUTBUF_DEFAULT_SIZE (256 * 1024)
+
+struct outbuf {
+    int fd;                      // -1 for a memory writer
+    char *buf;
+    size_t cap;
+    size_t len;
+    unsigned long long written;  // bytes handed to write()/writev()
+    int error;                   // errno of the first failed write, else 0
+};
+
+// cap == 0 selects OUTBUF_DEFAULT_SIZE.  Returns 0 or -1.
+int out_init(struct outbuf *o, int fd, size_t cap);
+
+// A writer that only accumulates: the buffer grows as needed and
+// out_flush() is a no-op.  The bytes are in buf[0..len).
+int out_init_mem(struct outbuf *o, size_t cap);
+
+void out_write(struct outbuf *o, const char *s, size_t n);
+void out_puts(struct outbuf *o, const char *s);
+void out_char(struct outbuf *o, char c);
+
+// n spaces
+void out_pad(struct outbuf *o, size_t n);
+
+// s left-aligned in a field of width columns
+void out_str_left(struct outbuf *o, const char *s, size_t width);
+
+// v right-aligned in a field of width columns
+void out_num_right(struct outbuf *o, long long v, size_t width);
+
+// Write out whatever is buffered.  Returns 0 or -1 (see o->error).
+int out_flush(struct outbuf *o);
+
+// Flush and release the buffer
+int out_close(struct outbuf *o);
+
+#endif
@@ -0,0 +1,225 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include "outbuf.h"
+#include "snapshot.h"
+
+#define SNAPSHOT_MAGIC   "LSVSNAP"
+#define SNAPSHOT_VERSION 1
+
+// Seconds a directory must have been left alone before it is cached.
+// Timestamps are coarser than the clock, so a change made in the same
+// tick as the scan could otherwise leave mtime unchanged.
+#define SNAPSHOT_RACY_SECS 1
+
+// File layout: header, count entry records, then the names, each
+// NUL-terminated.  Records keep the writer's struct entry layout;
+// entry_size rejects files from a build where it differs.
+struct snapshot_header {
+    char magic[8];
+    uint32_t version;
+    uint32_t entry_size;
+    uint64_t key;
+    uint64_t dev, ino;
+    int64_t mtime_sec, mtime_nsec;
+    int64_t ctime_sec, ctime_nsec;
+    uint64_t count;
+    uint64_t names_len;
+};
+
+char *snapshot_default_dir(void) {
+    const char *env = getenv("LSV_CACHE_DIR");
+    if (env && *env)
+        return strdup(env);
+
+    const char *base = getenv("XDG_CACHE_HOME");
+    const char *suffix = "/lsv";
+    if (!base || !*base) {
+        base = getenv("HOME");
+        suffix = "/.cache/lsv";
+        if (!base || !*base)
+            return NULL;
+    }
+
+    size_t len = strlen(base) + strlen(suffix) + 1;
+    char *dir = malloc(len);
+    if (dir)
+        snprintf(dir, len, "%s%s", base, suffix);
+    return dir;
+}
+
+int snapshot_mkdir(const char *dir) {
+    char path[4096];
+    size_t len = strlen(dir);
+    if (len >= sizeof(path)) {
+        errno = ENAMETOOLONG;
+        return -1;
+    }
+    memcpy(path, dir, len + 1);
+
+    for (char *p = path + 1; ; p++) {
+        if (*p != '/' && *p != '\0')
+            continue;
+        char c = *p;
+        *p = '\0';
+        if (mkdir(path, 0700) == -1 && errno != EEXIST)
+            return -1;
+        if (c == '\0')
+            return 0;
+        *p = c;
+    }
+}
+
+static void snapshot_file(const struct snapshot *s, char *buf, size_t len) {
+    snprintf(buf, len, "%s/%llx-%llx-%016llx.snap", s->cache_dir,
+             (unsigned long long)s->dir.st_dev, (unsigned long long)s->dir.st_ino,
+             (unsigned long long)s->key);
+}
+
+static int header_matches(const struct snapshot *s, const struct snapshot_header *h) {
+    return memcmp(h->magic, SNAPSHOT_MAGIC, sizeof(h->magic)) == 0 &&
+           h->version == SNAPSHOT_VERSION &&
+           h->entry_size == sizeof(struct entry) &&
+           h->key == s->key &&
+           h->dev == (uint64_t)s->dir.st_dev &&
+           h->ino == (uint64_t)s->dir.st_ino &&
+           h->mtime_sec == s->dir.st_mtim.tv_sec &&
+           h->mtime_nsec == s->dir.st_mtim.tv_nsec &&
+           h->ctime_sec == s->dir.st_ctim.tv_sec &&
+           h->ctime_nsec == s->dir.st_ctim.tv_nsec;
+}
+
+// Turn stored name offsets back into pointers, checking each one
+// stays inside the names region and is terminated
+static int relocate(struct entry *entries, uint64_t count, char *names, uint64_t names_len) {
+    for (uint64_t i = 0; i < count; i++) {
+        uint64_t off = (uint64_t)(uintptr_t)entries[i].name;
+        if (off >= names_len || names_len - off <= entries[i].namelen ||
+            names[off + entries[i].namelen] != '\0')
+            return -1;
+        entries[i].name = names + off;
+    }
+    return 0;
+}
+
+int snapshot_open(struct snapshot *s, const char *cache_dir, int dirfd, uint64_t key) {
+    memset(s, 0, sizeof(*s));
+    s->cache_dir = cache_dir;
+    s->key = key;
+    clock_gettime(CLOCK_REALTIME, &s->now);
+    if (fstat(dirfd, &s->dir) == -1)
+        return -1;
+
+    char path[4096];
+    snapshot_file(s, path, sizeof(path));
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd == -1)
+        return 0;
+
+    struct snapshot_header h;
+    struct stat st;
+    if (pread(fd, &h, sizeof(h), 0) != (ssize_t)sizeof(h) || !header_matches(s, &h) ||
+        fstat(fd, &st) == -1 || h.count > INT32_MAX ||
+        (uint64_t)st.st_size != sizeof(h) + h.count * sizeof(struct entry) + h.names_len) {
+        close(fd);
+        return 0;
+    }
+
+    // Private writable mapping: relocation only dirties the record
+    // pages, the names stay shared with the page cache
+    void *map = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED)
+        return 0;
+
+    struct entry *entries = (struct entry *)((char *)map + sizeof(h));
+    char *names = (char *)(entries + h.count);
+    if (relocate(entries, h.count, names, h.names_len) == -1) {
+        munmap(map, st.st_size);
+        return 0;
+    }
+
+    s->map = map;
+    s->maplen = st.st_size;
+    s->entries = entries;
+    s->count = (int)h.count;
+    return 1;
+}
+
+int snapshot_save(const struct snapshot *s, const struct entry *entries, int count) {
+    if (s->dir.st_mtim.tv_sec >= s->now.tv_sec - SNAPSHOT_RACY_SECS ||
+        s->dir.st_ctim.tv_sec >= s->now.tv_sec - SNAPSHOT_RACY_SECS)
+        return 0;
+
+    struct snapshot_header h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, SNAPSHOT_MAGIC, sizeof(h.magic));
+    h.version = SNAPSHOT_VERSION;
+    h.entry_size = sizeof(struct entry);
+    h.key = s->key;
+    h.dev = s->dir.st_dev;
+    h.ino = s->dir.st_ino;
+    h.mtime_sec = s->dir.st_mtim.tv_sec;
+    h.mtime_nsec = s->dir.st_mtim.tv_nsec;
+    h.ctime_sec = s->dir.st_ctim.tv_sec;
+    h.ctime_nsec = s->dir.st_ctim.tv_nsec;
+    h.count = count;
+    for (int i = 0; i < count; i++)
+        h.names_len += entries[i].namelen + 1;
+
+    // Write a temporary file and rename it over the old snapshot, so
+    // concurrent readers see either version whole
+    char path[4096], tmp[4096 + 16];
+    snapshot_file(s, path, sizeof(path));
+    snprintf(tmp, sizeof(tmp), "%s.XXXXXX", path);
+    int fd = mkstemp(tmp);
+    if (fd == -1)
+        return -1;
+
+    struct outbuf out;
+    if (out_init(&out, fd, 0) == -1) {
+        close(fd);
+        unlink(tmp);
+        return -1;
+    }
+    out_write(&out, (const char *)&h, sizeof(h));
+
+    uint64_t off = 0;
+    for (int i = 0; i < count; i++) {
+        struct entry rec = entries[i];
+        rec.name = (const char *)(uintptr_t)off;
+        out_write(&out, (const char *)&rec, sizeof(rec));
+        off += rec.namelen + 1;
+    }
+    for (int i = 0; i < count; i++)
+        out_write(&out, entries[i].name, entries[i].namelen + 1);
+
+    int rc = out_close(&out);
+    int saved = out.error;
+    if (close(fd) == -1 && rc == 0) {
+        rc = -1;
+        saved = errno;
+    }
+    if (rc == 0 && rename(tmp, path) == -1) {
+        rc = -1;
+        saved = errno;
+    }
+    if (rc == -1) {
+        unlink(tmp);
+        errno = saved;
+    }
+    return rc;
+}
+
+void snapshot_release(struct snapshot *s) {
+    if (s->map)
+        munmap(s->map, s->maplen);
+    s->map = NULL;
+    s->entries = NULL;
+    s->count = 0;
+}
@@ -0,0 +1,58 @@
+/* ===========================================================
+ * snapshot.h - Memory-mapped listing cache (--cache)
+ *
+ * After a sorted listing, the entry table is written to a compact
+ * binary file named after the directory's device, inode and an
+ * options key.  The next run stats the directory; if its inode,
+ * mtime and ctime still match the snapshot header, the file is
+ * mapped and rendered as is: no getdents64, no stat, no sort.
+ *
+ * Entry records are stored in struct entry layout with name
+ * offsets in place of pointers, so loading is one mmap plus a
+ * pass that turns offsets back into pointers.  Only entries added
+ * or removed change a directory's mtime: metadata of files that
+ * were rewritten in place is shown as of the snapshot.
+ * =========================================================== */
+#ifndef LSV_SNAPSHOT_H
+#define LSV_SNAPSHOT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/stat.h>
+#include <time.h>
+
+#include "entry.h"
+
+struct snapshot {
+    const char *cache_dir;
+    uint64_t key;            // fingerprint of the options that shaped the table
+    struct stat dir;         // directory as seen before the scan
+    struct timespec now;     // when dir was taken, for the racy check
+    void *map;
+    size_t maplen;
+    struct entry *entries;   // valid after a hit, points into map
+    int count;
+};
+
+// Default cache location: $LSV_CACHE_DIR, $XDG_CACHE_HOME/lsv or
+// ~/.cache/lsv.  Returns a malloc'd path or NULL.
+char *snapshot_default_dir(void);
+
+// Create the cache directory and any missing parents (mode 0700)
+int snapshot_mkdir(const char *dir);
+
+// Look up the snapshot for the directory open on dirfd.  Returns 1
+// on a hit (s->entries, s->count are set), 0 on a miss and -1 if
+// the directory cannot be stat'ed.  On a miss s still remembers the
+// directory for snapshot_save().
+int snapshot_open(struct snapshot *s, const char *cache_dir, int dirfd, uint64_t key);
+
+// Store entries[0..count), in final display order, for the
+// directory recorded by snapshot_open().  A directory changed too
+// recently to be told apart by its timestamps is not cached.
+// Returns 0 or -1 with errno set.
+int snapshot_save(const struct snapshot *s, const struct entry *entries, int count);
+
+void snapshot_release(struct snapshot *s);
+
+#endif
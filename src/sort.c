@@ -0,0 +1,405 @@
+#define _GNU_SOURCE
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <wchar.h>
+#include <locale.h>
+
+#include "arena.h"
+#include "sort.h"
+
+// Buckets at or below this size are finished with insertion sort
+#define SORT_SMALL 32
+
+// Collation key class bytes: names valid in the locale's encoding
+// sort before names that are not
+#define CLASS_VALID   0x01
+#define CLASS_INVALID 0x02
+
+// Up to 8 string bytes starting at depth, packed big-endian and
+// zero-padded past the terminating NUL.  depth never points past
+// the NUL (see radix_sort).
+static uint64_t str_key(const char *str, size_t depth) {
+    const unsigned char *p = (const unsigned char *)str + depth;
+    uint64_t key = 0;
+    int i = 0;
+
+    for (; i < 8 && p[i]; i++)
+        key = (key << 8) | p[i];
+    for (; i < 8; i++)
+        key <<= 8;
+    return key;
+}
+
+// A zero byte in the key means the string ended inside it
+static int key_has_end(uint64_t key) {
+    return ((key - 0x0101010101010101ULL) & ~key & 0x8080808080808080ULL) != 0;
+}
+
+static int tie_cmp(const struct sort_item *a, const struct sort_item *b, int tiebreak) {
+    return tiebreak ? strcmp(a->e->name, b->e->name) : 0;
+}
+
+// Full comparison for items whose strings agree before depth
+static int item_cmp(const struct sort_item *a, const struct sort_item *b, size_t depth, int tiebreak) {
+    if (a->key != b->key)
+        return a->key < b->key ? -1 : 1;
+    if (key_has_end(a->key))
+        return tie_cmp(a, b, tiebreak);
+    int c = strcmp(a->str + depth + 8, b->str + depth + 8);
+    return c ? c : tie_cmp(a, b, tiebreak);
+}
+
+static void insertion_sort(struct sort_item *items, size_t n, size_t depth, int tiebreak) {
+    for (size_t i = 1; i < n; i++) {
+        struct sort_item tmp = items[i];
+        size_t j = i;
+        while (j > 0 && item_cmp(&tmp, &items[j - 1], depth, tiebreak) < 0) {
+            items[j] = items[j - 1];
+            j--;
+        }
+        items[j] = tmp;
+    }
+}
+
+static int tie_qsort_cmp(const void *a, const void *b) {
+    return strcmp(((const struct sort_item *)a)->e->name, ((const struct sort_item *)b)->e->name);
+}
+
+// Items whose strings are identical: order by entry name if asked
+static void sort_ties(struct sort_item *items, size_t n, int tiebreak) {
+    if (tiebreak && n > 1)
+        qsort(items, n, sizeof(*items), tie_qsort_cmp);
+}
+
+// MSD radix sort on key byte `byte` (0 = most significant); strings
+// in items already agree on their first depth + byte bytes.
+static void radix_sort(struct sort_item *items, struct sort_item *tmp, size_t n,
+                       size_t depth, int byte, int tiebreak) {
+    for (;;) {
+        if (n <= SORT_SMALL) {
+            insertion_sort(items, n, depth, tiebreak);
+            return;
+        }
+
+        if (byte == 8) {
+            // Every key is identical here; done if the strings ended,
+            // otherwise reload the keys 8 bytes further in.
+            if (key_has_end(items[0].key)) {
+                sort_ties(items, n, tiebreak);
+                return;
+            }
+            depth += 8;
+            for (size_t i = 0; i < n; i++)
+                items[i].key = str_key(items[i].str, depth);
+            byte = 0;
+        }
+
+        int shift = 56 - 8 * byte;
+        size_t count[256] = { 0 };
+        for (size_t i = 0; i < n; i++)
+            count[(items[i].key >> shift) & 0xff]++;
+
+        // Skip the scatter when one bucket holds everything
+        if (count[(items[0].key >> shift) & 0xff] == n) {
+            if (((items[0].key >> shift) & 0xff) == 0) {
+                sort_ties(items, n, tiebreak);   // all strings ended here
+                return;
+            }
+            byte++;
+            continue;
+        }
+
+        size_t start[256], pos = 0;
+        for (int b = 0; b < 256; b++) {
+            start[b] = pos;
+            pos += count[b];
+        }
+        size_t fill[256];
+        memcpy(fill, start, sizeof(fill));
+        for (size_t i = 0; i < n; i++)
+            tmp[fill[(items[i].key >> shift) & 0xff]++] = items[i];
+        memcpy(items, tmp, n * sizeof(*items));
+
+        // Bucket 0 holds strings that ended: they are equal
+        sort_ties(items, count[0], tiebreak);
+        for (int b = 1; b < 256; b++) {
+            if (count[b] > 1)
+                radix_sort(items + start[b], tmp, count[b], depth, byte + 1, tiebreak);
+        }
+        return;
+    }
+}
+
+// Reorder entries so that entries[j] becomes the entry items[j]
+// pointed at, following permutation cycles in place.
+static void apply_order(struct entry *entries, struct sort_item *items, size_t n) {
+    // Reuse the key field as "source index for slot j"
+    for (size_t j = 0; j < n; j++)
+        items[j].key = (uint64_t)(items[j].e - entries);
+
+    for (size_t i = 0; i < n; i++) {
+        if (items[i].key == i)
+            continue;
+        struct entry saved = entries[i];
+        size_t j = i;
+        while (items[j].key != i) {
+            size_t src = (size_t)items[j].key;
+            entries[j] = entries[src];
+            items[j].key = j;
+            j = src;
+        }
+        entries[j] = saved;
+        items[j].key = j;
+    }
+}
+
+// Sort entries by the string each item carries, then permute them
+static void sort_items(struct entry *entries, struct sort_item *items, size_t n, int tiebreak) {
+    for (size_t i = 0; i < n; i++)
+        items[i].key = str_key(items[i].str, 0);
+    radix_sort(items, items + n, n, 0, 0, tiebreak);
+    apply_order(entries, items, n);
+}
+
+int sort_entries_by_name(struct entry *entries, int count) {
+    if (count < 2)
+        return 0;
+
+    size_t n = (size_t)count;
+    struct sort_item *items = malloc(2 * n * sizeof(*items));
+    if (!items)
+        return -1;
+
+    for (size_t i = 0; i < n; i++) {
+        items[i].e = &entries[i];
+        items[i].str = entries[i].name;
+    }
+    sort_items(entries, items, n, 0);
+
+    free(items);
+    return 0;
+}
+
+// ==============================
+// Locale collation
+// ==============================
+
+static int name_is_valid(const char *name) {
+    if (MB_CUR_MAX == 1)
+        return 1;
+
+    mbstate_t st;
+    memset(&st, 0, sizeof(st));
+    const unsigned char *p = (const unsigned char *)name;
+    while (*p) {
+        if (*p < 0x80) {     // ASCII is valid in every supported encoding
+            p++;
+            continue;
+        }
+        size_t n = mbrtowc(NULL, (const char *)p, MB_LEN_MAX, &st);
+        if (n == (size_t)-1 || n == (size_t)-2 || n == 0)
+            return 0;
+        p += n;
+    }
+    return 1;
+}
+
+// Class byte followed by the strxfrm() key, or by the raw name for
+// names the locale cannot decode (they skip strxfrm entirely)
+static const char *collation_key(struct arena *a, const char *name, size_t namelen) {
+    if (!name_is_valid(name)) {
+        char *key = arena_alloc(a, namelen + 2);
+        if (!key)
+            return NULL;
+        key[0] = CLASS_INVALID;
+        memcpy(key + 1, name, namelen + 1);
+        return key;
+    }
+
+    // Guess generously; strxfrm reports the size it really needs
+    size_t cap = 4 * namelen + 16;
+    char *key = arena_alloc(a, cap + 1);
+    if (!key)
+        return NULL;
+    key[0] = CLASS_VALID;
+    size_t need = strxfrm(key + 1, name, cap);
+    if (need >= cap) {
+        key = arena_alloc(a, need + 2);
+        if (!key)
+            return NULL;
+        key[0] = CLASS_VALID;
+        strxfrm(key + 1, name, need + 1);
+    }
+    return key;
+}
+
+int sort_entries_by_collation(struct entry *entries, int count) {
+    if (count < 2)
+        return 0;
+
+    size_t n = (size_t)count;
+    struct sort_item *items = malloc(2 * n * sizeof(*items));
+    if (!items)
+        return -1;
+
+    struct arena keys;
+    arena_init(&keys);
+    for (size_t i = 0; i < n; i++) {
+        items[i].e = &entries[i];
+        items[i].str = collation_key(&keys, entries[i].name, entries[i].namelen);
+        if (!items[i].str) {
+            arena_free(&keys);
+            free(items);
+            return -1;
+        }
+    }
+
+    // Names that collate equal are ordered bytewise for a total order
+    sort_items(entries, items, n, 1);
+
+    arena_free(&keys);
+    free(items);
+    return 0;
+}
+
+int compare_names(const void *a, const void *b) {
+    const struct entry *e1 = a;
+    const struct entry *e2 = b;
+    return strcmp(e1->name, e2->name);
+}
+
+int compare_collated(const void *a, const void *b) {
+    const struct entry *e1 = a;
+    const struct entry *e2 = b;
+    int v1 = name_is_valid(e1->name), v2 = name_is_valid(e2->name);
+
+    if (v1 != v2)
+        return v1 ? -1 : 1;
+    if (v1) {
+        int c = strcoll(e1->name, e2->name);
+        if (c)
+            return c;
+    }
+    return strcmp(e1->name, e2->name);
+}
+
+// ==============================
+// Metadata keys (-t, -S) and -r
+// ==============================
+
+// Packed sort pair: the metadata key and the entry's position
+struct key_pair {
+    uint64_t key;
+    uint32_t index;
+};
+
+// Order-preserving map to unsigned, inverted so that larger values
+// (newer, bigger) come first
+static uint64_t meta_key(const struct entry *e, enum sort_field field) {
+    int64_t v;
+    if (field == SORT_MTIME)
+        v = (int64_t)e->meta.mtime.tv_sec * 1000000000LL + e->meta.mtime.tv_nsec;
+    else
+        v = (int64_t)e->meta.size;
+    return ~((uint64_t)v ^ 0x8000000000000000ULL);
+}
+
+// Stable LSD radix sort on the key, skipping bytes all keys share
+static void lsd_sort(struct key_pair *pairs, struct key_pair *tmp, size_t n) {
+    uint64_t all_or = 0, all_and = ~0ULL;
+    for (size_t i = 0; i < n; i++) {
+        all_or |= pairs[i].key;
+        all_and &= pairs[i].key;
+    }
+
+    for (int shift = 0; shift < 64; shift += 8) {
+        if ((((all_or ^ all_and) >> shift) & 0xff) == 0)
+            continue;
+
+        size_t count[256] = { 0 };
+        for (size_t i = 0; i < n; i++)
+            count[(pairs[i].key >> shift) & 0xff]++;
+        size_t pos = 0;
+        for (int b = 0; b < 256; b++) {
+            size_t c = count[b];
+            count[b] = pos;
+            pos += c;
+        }
+        for (size_t i = 0; i < n; i++)
+            tmp[count[(pairs[i].key >> shift) & 0xff]++] = pairs[i];
+
+        memcpy(pairs, tmp, n * sizeof(*pairs));
+    }
+}
+
+static int sort_by_meta_key(struct entry *entries, size_t n, enum sort_field field) {
+    struct key_pair *pairs = malloc(2 * n * sizeof(*pairs));
+    if (!pairs)
+        return -1;
+
+    for (size_t i = 0; i < n; i++) {
+        pairs[i].key = meta_key(&entries[i], field);
+        pairs[i].index = (uint32_t)i;
+    }
+    lsd_sort(pairs, pairs + n, n);
+
+    // Permute by cycles; index doubles as the "already placed" marker
+    for (size_t i = 0; i < n; i++) {
+        if (pairs[i].index == i)
+            continue;
+        struct entry saved = entries[i];
+        size_t j = i;
+        while (pairs[j].index != i) {
+            size_t src = pairs[j].index;
+            entries[j] = entries[src];
+            pairs[j].index = (uint32_t)j;
+            j = src;
+        }
+        entries[j] = saved;
+        pairs[j].index = (uint32_t)j;
+    }
+
+    free(pairs);
+    return 0;
+}
+
+int sort_compare(const struct entry *a, const struct entry *b, const void *ctx) {
+    const struct sort_spec *spec = ctx;
+    int c = 0;
+
+    if (spec->field != SORT_NAME) {
+        uint64_t ka = meta_key(a, spec->field), kb = meta_key(b, spec->field);
+        if (ka != kb)
+            c = ka < kb ? -1 : 1;
+    }
+    if (c == 0)
+        c = spec->collate ? compare_collated(a, b) : compare_names(a, b);
+    return spec->reverse ? -c : c;
+}
+
+static int sort_compare_r(const void *a, const void *b, void *ctx) {
+    return sort_compare(a, b, ctx);
+}
+
+void sort_entries(const struct sort_spec *spec, struct entry *entries, int count) {
+    if (count < 2)
+        return;
+
+    int rc = spec->collate ? sort_entries_by_collation(entries, count)
+                           : sort_entries_by_name(entries, count);
+    if (rc == 0 && spec->field != SORT_NAME)
+        rc = sort_by_meta_key(entries, (size_t)count, spec->field);
+    if (rc == -1) {
+        qsort_r(entries, count, sizeof(struct entry), sort_compare_r, (void *)spec);
+        return;
+    }
+
+    if (spec->reverse) {
+        for (int i = 0, j = count - 1; i < j; i++, j--) {
+            struct entry tmp = entries[i];
+            entries[i] = entries[j];
+            entries[j] = tmp;
+        }
+    }
+}
@@ -0,0 +1,66 @@
+/* ===========================================================
+ * sort.h - Sort engine for entry tables
+ *
+ * qsort(compare_names) chases every entry's name pointer on each
+ * comparison.  The engine instead sorts a compact array of items
+ * that carry an inline 8-byte big-endian key taken from the name
+ * (bytes [depth, depth + 8)), using MSD radix sort over the key
+ * bytes.  When a bucket shares all 8 bytes the key is reloaded from
+ * the next 8 name bytes, so long shared prefixes such as
+ * "build-000001.o" cost one reload instead of full strcmp()s.
+ * The resulting order is exactly strcmp() order.
+ * =========================================================== */
+#ifndef LSV_SORT_H
+#define LSV_SORT_H
+
+#include <stdint.h>
+
+#include "entry.h"
+
+enum sort_field {
+    SORT_NAME,               // default: alphabetical
+    SORT_MTIME,              // -t: newest first
+    SORT_SIZE,               // -S: largest first
+};
+
+// Complete description of a listing order
+struct sort_spec {
+    enum sort_field field;
+    int reverse;             // -r
+    int collate;             // names compared in LC_COLLATE order
+};
+
+struct sort_item {
+    uint64_t key;            // big-endian bytes of str at the current depth
+    const char *str;         // what is being sorted on (name or collation key)
+    struct entry *e;
+};
+
+// Sort entries[0..count) by name in strcmp() order, in place.
+// Returns 0, or -1 if scratch memory could not be allocated (the
+// entries are then left untouched).
+int sort_entries_by_name(struct entry *entries, int count);
+
+// Locale-correct order for the current LC_COLLATE.  Every name's
+// strxfrm() key is computed once into an arena and the keys are
+// radix sorted bytewise, so this costs about the same as the strcmp
+// path.  Names the locale cannot decode skip strxfrm and sort after
+// all others in byte order; names that collate equal are ordered by
+// strcmp().  Returns 0 or -1 like sort_entries_by_name().
+int sort_entries_by_collation(struct entry *entries, int count);
+
+// qsort-style comparators giving the same orders as the two engines
+int compare_names(const void *a, const void *b);
+int compare_collated(const void *a, const void *b);
+
+// Sort entries in place in the order spec describes.  Metadata keys
+// (mtime in ns, size) are packed into a compact (key, index) array
+// and radix sorted stably over the name-sorted entries, so ties stay
+// in name order.  Falls back to qsort_r() if scratch memory is short.
+void sort_entries(const struct sort_spec *spec, struct entry *entries, int count);
+
+// Comparator giving exactly the sort_entries() order (ctx is the
+// struct sort_spec); used to merge spilled runs
+int sort_compare(const struct entry *a, const struct entry *b, const void *ctx);
+
+#endif
@@ -0,0 +1,80 @@
+#include <errno.h>
+#include <pthread.h>
+
+#include "statpool.h"
+
+// Indices handed out per queue pop; large enough to keep lock
+// traffic negligible, small enough to balance slow lookups.
+#define STATPOOL_CHUNK 32
+
+struct statpool {
+    int dirfd;
+    struct entry *entries;
+    unsigned want;
+    int count;
+    int next;                // head of the shared work queue
+    pthread_mutex_t lock;
+};
+
+static void fetch_one(struct statpool *pool, int i) {
+    struct file_meta *m = &pool->entries[i].meta;
+    if (m->valid)
+        return;
+    if (meta_fetch(pool->dirfd, pool->entries[i].name, pool->want, m) == -1) {
+        m->valid = 0;
+        m->error = errno;
+    }
+}
+
+static void *statpool_worker(void *arg) {
+    struct statpool *pool = arg;
+
+    for (;;) {
+        pthread_mutex_lock(&pool->lock);
+        int start = pool->next;
+        pool->next += STATPOOL_CHUNK;
+        pthread_mutex_unlock(&pool->lock);
+
+        if (start >= pool->count)
+            break;
+        int end = start + STATPOOL_CHUNK;
+        if (end > pool->count) end = pool->count;
+        for (int i = start; i < end; i++)
+            fetch_one(pool, i);
+    }
+    return NULL;
+}
+
+void meta_fetch_all(int dirfd, struct entry *entries, int count, unsigned want,
+                    int jobs) {
+    struct statpool pool = {
+        .dirfd = dirfd, .entries = entries,
+        .want = want, .count = count, .next = 0,
+    };
+
+    if (jobs > STATPOOL_MAX_JOBS) jobs = STATPOOL_MAX_JOBS;
+    if (jobs > (count + STATPOOL_CHUNK - 1) / STATPOOL_CHUNK)
+        jobs = (count + STATPOOL_CHUNK - 1) / STATPOOL_CHUNK;
+
+    if (jobs <= 1) {
+        for (int i = 0; i < count; i++)
+            fetch_one(&pool, i);
+        return;
+    }
+
+    pthread_mutex_init(&pool.lock, NULL);
+
+    pthread_t threads[STATPOOL_MAX_JOBS];
+    int started = 0;
+    for (; started < jobs; started++) {
+        if (pthread_create(&threads[started], NULL, statpool_worker, &pool) != 0)
+            break;
+    }
+    // If no thread could be started the caller still gets results
+    if (started == 0)
+        statpool_worker(&pool);
+    for (int t = 0; t < started; t++)
+        pthread_join(threads[t], NULL);
+
+    pthread_mutex_destroy(&pool.lock);
+}
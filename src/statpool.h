@@ -0,0 +1,23 @@
+/* ===========================================================
+ * statpool.h - Fixed pthread pool for bulk metadata fetches
+ *
+ * The names are collected first; workers then pull chunks of
+ * indices from a shared queue and write each result into its own
+ * slot, so output order never depends on thread timing.
+ * =========================================================== */
+#ifndef LSV_STATPOOL_H
+#define LSV_STATPOOL_H
+
+#include "entry.h"
+
+#define STATPOOL_MAX_JOBS 256
+
+// Fill entries[i].meta for every entry using up to jobs threads
+// (jobs <= 1 runs inline).  A failed lookup leaves valid == 0 and
+// the errno value in meta.error.  Entries whose meta.valid is already
+// non-zero were filled in by the caller (e.g. from d_type) and are
+// skipped.
+void meta_fetch_all(int dirfd, struct entry *entries, int count, unsigned want,
+                    int jobs);
+
+#endif
@@ -0,0 +1,82 @@
+#include <time.h>
+#include <sys/resource.h>
+
+#include "stats.h"
+
+// Deepest phase nesting tracked per thread; deeper phases are ignored
+#define STATS_MAX_DEPTH 8
+
+int stats_enabled;
+unsigned long long stats_counters[STATS_COUNTERS];
+
+static unsigned long long phase_ns[STATS_PHASES];
+static unsigned long long start_ns;
+
+struct phase_frame {
+    enum stats_phase phase;
+    unsigned long long start;
+    unsigned long long children;     // time spent in nested phases
+};
+
+static __thread struct phase_frame frames[STATS_MAX_DEPTH];
+static __thread int depth;
+
+static const char *const phase_names[STATS_PHASES] = {
+    "scan", "metadata", "ids", "sort", "render", "flush",
+};
+
+static unsigned long long now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long long)ts.tv_sec * 1000000000ull + (unsigned long long)ts.tv_nsec;
+}
+
+void stats_enable(void) {
+    start_ns = now_ns();
+    stats_enabled = 1;
+}
+
+void stats_begin(enum stats_phase phase) {
+    if (!stats_enabled)
+        return;
+    if (depth < STATS_MAX_DEPTH) {
+        frames[depth].phase = phase;
+        frames[depth].start = now_ns();
+        frames[depth].children = 0;
+    }
+    depth++;
+}
+
+void stats_end(enum stats_phase phase) {
+    if (!stats_enabled || depth == 0)
+        return;
+    depth--;
+    if (depth >= STATS_MAX_DEPTH || frames[depth].phase != phase)
+        return;
+
+    unsigned long long elapsed = now_ns() - frames[depth].start;
+    unsigned long long own = elapsed > frames[depth].children ? elapsed - frames[depth].children : 0;
+    __atomic_add_fetch(&phase_ns[phase], own, __ATOMIC_RELAXED);
+    if (depth > 0)
+        frames[depth - 1].children += elapsed;
+}
+
+void stats_report(FILE *fp) {
+    double total_ms = (now_ns() - start_ns) / 1e6;
+    struct rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+
+    fprintf(fp, "lsv stats (phase times summed over threads):\n");
+    for (int p = 0; p < STATS_PHASES; p++)
+        fprintf(fp, "  %-10s %12.3f ms\n", phase_names[p], phase_ns[p] / 1e6);
+    fprintf(fp, "  %-10s %12.3f ms\n", "wall", total_ms);
+
+    unsigned long long *c = stats_counters;
+    fprintf(fp, "  syscalls   getdents64 %llu, stat %llu, io_uring_enter %llu, write %llu\n",
+            c[STATS_GETDENTS], c[STATS_STAT], c[STATS_URING_ENTER], c[STATS_WRITE]);
+    fprintf(fp, "  nss        %llu lookups\n", c[STATS_NSS]);
+    fprintf(fp, "  entries    %llu\n", c[STATS_ENTRIES]);
+    fprintf(fp, "  output     %llu bytes\n", c[STATS_BYTES]);
+    fprintf(fp, "  memory     entry table peak %llu bytes, peak RSS %ld KiB\n",
+            c[STATS_TABLE_PEAK], ru.ru_maxrss);
+}
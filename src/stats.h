@@ -0,0 +1,65 @@
+/* ===========================================================
+ * stats.h - Phase timers and counters for --stats
+ *
+ * Always compiled in: while --stats is off every hook is a single
+ * predictable branch on stats_enabled.  Counters are relaxed
+ * atomics, so walker and statpool threads can update them freely.
+ *
+ * Phase timers nest per thread and record exclusive time: a write
+ * issued from inside render, or an NSS lookup from inside the long
+ * format, is charged to flush or ids and not to render as well.
+ * =========================================================== */
+#ifndef LSV_STATS_H
+#define LSV_STATS_H
+
+#include <stdio.h>
+
+enum stats_phase {
+    STATS_SCAN,              // getdents64 and entry table building
+    STATS_META,              // statx / io_uring metadata fetches
+    STATS_IDS,               // getpwuid / getgrgid on cache misses
+    STATS_SORT,
+    STATS_RENDER,            // formatting, including external merge
+    STATS_FLUSH,             // write / writev to the output fd
+    STATS_PHASES
+};
+
+enum stats_counter {
+    STATS_GETDENTS,          // getdents64 calls
+    STATS_STAT,              // statx / fstatat calls and IORING_OP_STATX requests
+    STATS_URING_ENTER,       // io_uring_enter calls
+    STATS_WRITE,             // write / writev calls on the output
+    STATS_NSS,               // passwd / group lookups that reached NSS
+    STATS_ENTRIES,           // entries rendered
+    STATS_BYTES,             // bytes written to the output
+    STATS_TABLE_PEAK,        // largest entry table, in bytes
+    STATS_COUNTERS
+};
+
+extern int stats_enabled;
+extern unsigned long long stats_counters[STATS_COUNTERS];
+
+// Start the run clock and turn the hooks on
+void stats_enable(void);
+
+void stats_begin(enum stats_phase phase);
+void stats_end(enum stats_phase phase);
+
+static inline void stats_add(enum stats_counter c, unsigned long long n) {
+    if (stats_enabled)
+        __atomic_add_fetch(&stats_counters[c], n, __ATOMIC_RELAXED);
+}
+
+static inline void stats_max(enum stats_counter c, unsigned long long v) {
+    if (!stats_enabled)
+        return;
+    unsigned long long cur = __atomic_load_n(&stats_counters[c], __ATOMIC_RELAXED);
+    while (v > cur && !__atomic_compare_exchange_n(&stats_counters[c], &cur, v, 0,
+                                                   __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+        ;
+}
+
+// Print the timers and counters
+void stats_report(FILE *fp);
+
+#endif
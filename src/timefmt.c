@@ -0,0 +1,85 @@
+#define _GNU_SOURCE
+#include <string.h>
+#include <pthread.h>
+
+#include "timefmt.h"
+
+static pthread_once_t tz_once = PTHREAD_ONCE_INIT;
+
+void timefmt_init(struct timefmt *tf) {
+    memset(tf, 0, sizeof(*tf));
+    pthread_once(&tz_once, tzset);
+}
+
+// Cache the local day containing t, unless a UTC offset change
+// (DST switch) falls inside it; such days use the slow path.
+static void cache_day(struct timefmt *tf, time_t t, const struct tm *tm) {
+    time_t start = t - (tm->tm_hour * 3600 + tm->tm_min * 60 + tm->tm_sec);
+    struct tm first, last;
+
+    tf->day_end = 0;
+    if (!localtime_r(&start, &first))
+        return;
+    time_t end_probe = start + 86399;
+    if (!localtime_r(&end_probe, &last))
+        return;
+    if (first.tm_gmtoff != tm->tm_gmtoff || last.tm_gmtoff != tm->tm_gmtoff)
+        return;
+
+    tf->prefix_len = strftime(tf->day_prefix, sizeof(tf->day_prefix), "%b %d ", tm);
+    if (tf->prefix_len == 0)
+        return;
+    tf->day_start = start;
+    tf->day_end = start + 86400;
+}
+
+// sec is t's second within its local minute: the minute boundary is
+// local, which differs from the UTC one when the offset has seconds
+static void remember_minute(struct timefmt *tf, time_t t, int sec, const char *s, size_t len) {
+    tf->minute_start = t - sec;
+    tf->have_minute = 1;
+    memcpy(tf->last, s, len);
+    tf->last_len = len;
+}
+
+size_t timefmt_mtime(struct timefmt *tf, time_t t, char *out) {
+    // Same minute: reuse the whole string
+    if (tf->have_minute && t >= tf->minute_start && t < tf->minute_start + 60) {
+        memcpy(out, tf->last, tf->last_len + 1);
+        return tf->last_len;
+    }
+
+    // Same local day: reuse the prefix, compute HH:MM arithmetically
+    if (tf->day_end && t >= tf->day_start && t < tf->day_end) {
+        int secs = (int)(t - tf->day_start);
+        int hour = secs / 3600, min = (secs / 60) % 60;
+        char *p = out;
+
+        memcpy(p, tf->day_prefix, tf->prefix_len);
+        p += tf->prefix_len;
+        *p++ = (char)('0' + hour / 10);
+        *p++ = (char)('0' + hour % 10);
+        *p++ = ':';
+        *p++ = (char)('0' + min / 10);
+        *p++ = (char)('0' + min % 10);
+        *p = '\0';
+
+        size_t len = (size_t)(p - out);
+        if (t >= 0)
+            remember_minute(tf, t, secs % 60, out, len);
+        return len;
+    }
+
+    struct tm tm;
+    if (!localtime_r(&t, &tm)) {
+        out[0] = '\0';
+        return 0;
+    }
+    size_t len = strftime(out, 32, "%b %d %H:%M", &tm);
+
+    if (t >= 0) {
+        cache_day(tf, t, &tm);
+        remember_minute(tf, t, tm.tm_sec, out, len);
+    }
+    return len;
+}
@@ -0,0 +1,36 @@
+/* ===========================================================
+ * timefmt.h - Cached "%b %d %H:%M" formatting for the mtime column
+ *
+ * Entries in one directory tend to share a day or even a minute.
+ * The formatter remembers the last minute it produced and the local
+ * day it fell in; a timestamp in the same minute reuses the whole
+ * string, one in the same day reuses the "Mon DD " prefix and only
+ * fills in HH:MM.  Anything else goes through localtime_r().
+ * =========================================================== */
+#ifndef LSV_TIMEFMT_H
+#define LSV_TIMEFMT_H
+
+#include <stddef.h>
+#include <time.h>
+
+#define TIMEFMT_LEN 12           // "Mon DD HH:MM"
+
+// Per-caller state; use one per thread
+struct timefmt {
+    time_t day_start;            // local midnight of the cached day
+    time_t day_end;              // first second after it (0 = no day cached)
+    char day_prefix[16];         // "Mon DD "
+    size_t prefix_len;
+    time_t minute_start;         // first second of the cached minute
+    int have_minute;
+    char last[32];               // string for the cached minute
+    size_t last_len;
+};
+
+// The timezone is read (tzset) on the first call of the run only
+void timefmt_init(struct timefmt *tf);
+
+// Format t into out (at least 32 bytes), return the length
+size_t timefmt_mtime(struct timefmt *tf, time_t t, char *out);
+
+#endif
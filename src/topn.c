@@ -0,0 +1,124 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "topn.h"
+
+void topn_init(struct topn *t, int limit, entry_cmp_fn cmp, const void *ctx) {
+    memset(t, 0, sizeof(*t));
+    t->limit = limit;
+    t->cmp = cmp;
+    t->ctx = ctx;
+}
+
+// Entries that sort later are "larger"; the root holds the largest
+static int worse(const struct topn *t, int i, int j) {
+    return t->cmp(&t->heap[i], &t->heap[j], t->ctx) > 0;
+}
+
+static void swap(struct topn *t, int i, int j) {
+    struct entry tmp = t->heap[i];
+    t->heap[i] = t->heap[j];
+    t->heap[j] = tmp;
+}
+
+static void sift_up(struct topn *t, int i) {
+    while (i > 0) {
+        int parent = (i - 1) / 2;
+        if (!worse(t, i, parent))
+            break;
+        swap(t, i, parent);
+        i = parent;
+    }
+}
+
+static void sift_down(struct topn *t, int i, int count) {
+    for (;;) {
+        int largest = i, l = 2 * i + 1, r = l + 1;
+        if (l < count && worse(t, l, largest)) largest = l;
+        if (r < count && worse(t, r, largest)) largest = r;
+        if (largest == i)
+            break;
+        swap(t, i, largest);
+        i = largest;
+    }
+}
+
+// Make room for one more entry: heap slot count and its name buffer
+static int grow(struct topn *t) {
+    if (t->count == t->capacity) {
+        int capacity = t->capacity ? t->capacity * 2 : TOPN_BLOCK;
+        if (capacity > t->limit)
+            capacity = t->limit;
+        struct entry *heap = realloc(t->heap, (size_t)capacity * sizeof(*heap));
+        if (!heap)
+            return -1;
+        t->heap = heap;
+        t->capacity = capacity;
+    }
+    if (t->count / TOPN_BLOCK == t->nblocks) {
+        char (**blocks)[256] = realloc(t->blocks, (t->nblocks + 1) * sizeof(*blocks));
+        if (!blocks)
+            return -1;
+        t->blocks = blocks;
+        t->blocks[t->nblocks] = malloc(TOPN_BLOCK * sizeof(**blocks));
+        if (!t->blocks[t->nblocks])
+            return -1;
+        t->nblocks++;
+    }
+    return 0;
+}
+
+int topn_wants(const struct topn *t, const struct entry *e) {
+    if (t->limit <= 0)
+        return 0;
+    return t->count < t->limit || t->cmp(e, &t->heap[0], t->ctx) < 0;
+}
+
+// Copy e into slot i, with its name in buf
+static void store(struct topn *t, int i, char *buf, const struct entry *e) {
+    memcpy(buf, e->name, e->namelen);
+    buf[e->namelen] = '\0';
+    t->heap[i] = *e;
+    t->heap[i].name = buf;
+}
+
+int topn_offer(struct topn *t, const struct entry *e) {
+    if (!topn_wants(t, e))
+        return 0;
+
+    if (t->count < t->limit) {
+        // Buffers 0..count-1 all belong to kept entries, so the next
+        // one is free
+        if (grow(t) == -1)
+            return -1;
+        store(t, t->count, t->blocks[t->count / TOPN_BLOCK][t->count % TOPN_BLOCK], e);
+        sift_up(t, t->count++);
+    } else {
+        // Evict the root and reuse its name buffer
+        store(t, 0, (char *)t->heap[0].name, e);
+        sift_down(t, 0, t->count);
+    }
+    return 0;
+}
+
+struct entry *topn_finish(struct topn *t, int *count) {
+    // Heapsort: repeatedly move the largest to the end
+    for (int n = t->count; n > 1; n--) {
+        swap(t, 0, n - 1);
+        sift_down(t, 0, n - 1);
+    }
+    *count = t->count;
+    return t->heap;
+}
+
+size_t topn_bytes(const struct topn *t) {
+    return (size_t)t->capacity * sizeof(struct entry) + (size_t)t->nblocks * TOPN_BLOCK * 256;
+}
+
+void topn_free(struct topn *t) {
+    for (int i = 0; i < t->nblocks; i++)
+        free(t->blocks[i]);
+    free(t->blocks);
+    free(t->heap);
+    memset(t, 0, sizeof(*t));
+}
@@ -0,0 +1,52 @@
+/* ===========================================================
+ * topn.h - Bounded selection of the first N entries (--limit)
+ *
+ * Keeps the N best entries seen so far in a binary heap whose root
+ * is the worst of them, so an entry that cannot make the cut costs
+ * one comparison and is never stored.  Each slot owns a fixed name
+ * buffer, allocated in blocks as the heap fills, so memory is O(N)
+ * however large the directory (and no more than the entries seen
+ * when there are fewer), and selecting from n entries is O(n log N).  The kept entries come
+ * out in exactly the order a full sort would give them.
+ * =========================================================== */
+#ifndef LSV_TOPN_H
+#define LSV_TOPN_H
+
+#include "entry.h"
+#include "extsort.h"
+
+// Name buffers allocated at a time
+#define TOPN_BLOCK 1024
+
+struct topn {
+    struct entry *heap;      // heap[0] is the worst entry kept
+    int count;
+    int capacity;
+    char (**blocks)[256];    // name buffers; slot k is blocks[k / TOPN_BLOCK]
+    int nblocks;
+    int limit;
+    entry_cmp_fn cmp;
+    const void *ctx;
+};
+
+void topn_init(struct topn *t, int limit, entry_cmp_fn cmp, const void *ctx);
+
+// Non-zero if e would be kept.  Only the fields cmp looks at need
+// to be filled in, so callers can test a bare name before paying
+// for a copy or a stat.
+int topn_wants(const struct topn *t, const struct entry *e);
+
+// Keep a copy of e if it is among the best so far.  Returns 0, or
+// -1 if the heap could not grow (e is then dropped).
+int topn_offer(struct topn *t, const struct entry *e);
+
+// Put the kept entries in cmp order and return them; *count is set.
+// They stay valid until topn_free().
+struct entry *topn_finish(struct topn *t, int *count);
+
+// Memory held: heap slots and name buffers
+size_t topn_bytes(const struct topn *t);
+
+void topn_free(struct topn *t);
+
+#endif
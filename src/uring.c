@@ -0,0 +1,269 @@
+#define _GNU_SOURCE
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+
+#include "stats.h"
+#include "uring.h"
+
+#if defined(__linux__) && defined(__NR_io_uring_setup) && defined(STATX_BASIC_STATS)
+#include <linux/io_uring.h>
+
+// Minimal raw-syscall ring; no liburing dependency
+struct uring {
+    int fd;
+    unsigned sq_entries, cq_entries;
+
+    void *sq_ptr, *cq_ptr;
+    size_t sq_len, cq_len;
+    struct io_uring_sqe *sqes;
+    size_t sqes_len;
+
+    unsigned *sq_head, *sq_tail, *sq_mask, *sq_array;
+    unsigned *cq_head, *cq_tail, *cq_mask;
+    struct io_uring_cqe *cqes;
+};
+
+static int uring_setup(struct uring *r, unsigned depth) {
+    struct io_uring_params p;
+    memset(&p, 0, sizeof(p));
+    memset(r, 0, sizeof(*r));
+
+    r->fd = (int)syscall(__NR_io_uring_setup, depth, &p);
+    if (r->fd < 0)
+        return -1;
+
+    r->sq_entries = p.sq_entries;
+    r->cq_entries = p.cq_entries;
+    r->sq_len = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    r->cq_len = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+    r->sqes_len = p.sq_entries * sizeof(struct io_uring_sqe);
+
+    r->sq_ptr = mmap(NULL, r->sq_len, PROT_READ | PROT_WRITE,
+                     MAP_SHARED | MAP_POPULATE, r->fd, IORING_OFF_SQ_RING);
+    r->cq_ptr = mmap(NULL, r->cq_len, PROT_READ | PROT_WRITE,
+                     MAP_SHARED | MAP_POPULATE, r->fd, IORING_OFF_CQ_RING);
+    r->sqes = mmap(NULL, r->sqes_len, PROT_READ | PROT_WRITE,
+                   MAP_SHARED | MAP_POPULATE, r->fd, IORING_OFF_SQES);
+    if (r->sq_ptr == MAP_FAILED || r->cq_ptr == MAP_FAILED || r->sqes == MAP_FAILED) {
+        int saved = errno;
+        if (r->sq_ptr != MAP_FAILED) munmap(r->sq_ptr, r->sq_len);
+        if (r->cq_ptr != MAP_FAILED) munmap(r->cq_ptr, r->cq_len);
+        if (r->sqes != MAP_FAILED) munmap(r->sqes, r->sqes_len);
+        close(r->fd);
+        errno = saved;
+        return -1;
+    }
+
+    char *sq = r->sq_ptr, *cq = r->cq_ptr;
+    r->sq_head = (unsigned *)(sq + p.sq_off.head);
+    r->sq_tail = (unsigned *)(sq + p.sq_off.tail);
+    r->sq_mask = (unsigned *)(sq + p.sq_off.ring_mask);
+    r->sq_array = (unsigned *)(sq + p.sq_off.array);
+    r->cq_head = (unsigned *)(cq + p.cq_off.head);
+    r->cq_tail = (unsigned *)(cq + p.cq_off.tail);
+    r->cq_mask = (unsigned *)(cq + p.cq_off.ring_mask);
+    r->cqes = (struct io_uring_cqe *)(cq + p.cq_off.cqes);
+    return 0;
+}
+
+static void uring_teardown(struct uring *r) {
+    munmap(r->sqes, r->sqes_len);
+    munmap(r->cq_ptr, r->cq_len);
+    munmap(r->sq_ptr, r->sq_len);
+    close(r->fd);
+}
+
+static int uring_enter(struct uring *r, unsigned submit, unsigned wait) {
+    int ret;
+    stats_add(STATS_URING_ENTER, 1);
+    do {
+        ret = (int)syscall(__NR_io_uring_enter, r->fd, submit, wait,
+                           wait ? IORING_ENTER_GETEVENTS : 0, NULL, 0);
+    } while (ret < 0 && errno == EINTR);
+    return ret;
+}
+
+int uring_available(void) {
+    static int cached = -1;
+    if (cached == -1) {
+        struct uring r;
+        cached = uring_setup(&r, 4) == 0;
+        if (cached)
+            uring_teardown(&r);
+    }
+    return cached;
+}
+
+// One metadata run: a statx buffer per slot; user_data is the slot
+struct uring_run {
+    struct uring r;
+    int dirfd;
+    unsigned want;
+    struct entry *entries;
+    struct statx *bufs;
+    int *slot_index;         // slot -> entry index
+    unsigned *free_slots;
+    unsigned nfree;
+};
+
+// Reap everything that has completed.  Returns the number reaped.
+static unsigned reap_completions(struct uring_run *run) {
+    struct uring *r = &run->r;
+    unsigned head = *r->cq_head;
+    unsigned ctail = __atomic_load_n(r->cq_tail, __ATOMIC_ACQUIRE);
+    unsigned reaped = 0;
+
+    for (; head != ctail; head++, reaped++) {
+        struct io_uring_cqe *cqe = &r->cqes[head & *r->cq_mask];
+        unsigned slot = (unsigned)cqe->user_data;
+        struct entry *e = &run->entries[run->slot_index[slot]];
+        struct file_meta *m = &e->meta;
+
+        memset(m, 0, sizeof(*m));
+        if (cqe->res == 0) {
+            meta_from_statx(&run->bufs[slot], m);
+        } else if (cqe->res == -EINVAL || cqe->res == -EOPNOTSUPP) {
+            // Kernel has io_uring but not IORING_OP_STATX
+            if (meta_fetch(run->dirfd, e->name, run->want, m) == -1)
+                m->error = errno;
+        } else {
+            m->error = -cqe->res;
+        }
+        run->free_slots[run->nfree++] = slot;
+    }
+    __atomic_store_n(r->cq_head, head, __ATOMIC_RELEASE);
+    return reaped;
+}
+
+int meta_fetch_all_uring(int dirfd, struct entry *entries, int count, unsigned want) {
+    struct uring_run run = { .dirfd = dirfd, .want = want, .entries = entries };
+    struct uring *r = &run.r;
+    if (uring_setup(r, URING_QUEUE_DEPTH) == -1)
+        return -1;
+
+    unsigned depth = r->sq_entries;
+    run.bufs = malloc(depth * sizeof(*run.bufs));
+    run.slot_index = malloc(depth * sizeof(*run.slot_index));
+    run.free_slots = malloc(depth * sizeof(*run.free_slots));
+    if (!run.bufs || !run.slot_index || !run.free_slots) {
+        free(run.bufs); free(run.slot_index); free(run.free_slots);
+        uring_teardown(r);
+        errno = ENOMEM;
+        return -1;
+    }
+    run.nfree = depth;
+    for (unsigned s = 0; s < depth; s++)
+        run.free_slots[s] = s;
+
+    unsigned int mask = meta_statx_mask(want);
+    int next = 0, done = 0;
+    unsigned unsubmitted = 0;    // in the SQ ring, not yet taken by the kernel
+    unsigned in_flight = 0;      // taken by the kernel, not yet reaped
+    int failed = 0;
+
+    while (done < count) {
+        // Fill the submission ring with as many requests as fit
+        unsigned tail = *r->sq_tail;
+        unsigned queued = 0;
+        while (next < count && run.nfree > 0) {
+            if (entries[next].meta.valid) {
+                next++;
+                done++;
+                continue;
+            }
+            unsigned slot = run.free_slots[--run.nfree];
+            unsigned idx = tail & *r->sq_mask;
+            struct io_uring_sqe *sqe = &r->sqes[idx];
+
+            memset(sqe, 0, sizeof(*sqe));
+            sqe->opcode = IORING_OP_STATX;
+            sqe->fd = dirfd;
+            sqe->addr = (unsigned long)entries[next].name;
+            sqe->len = mask;
+            sqe->off = (unsigned long)&run.bufs[slot];
+            sqe->statx_flags = AT_SYMLINK_NOFOLLOW | AT_STATX_SYNC_AS_STAT;
+            sqe->user_data = slot;
+            r->sq_array[idx] = idx;
+
+            run.slot_index[slot] = next++;
+            tail++;
+            queued++;
+        }
+        __atomic_store_n(r->sq_tail, tail, __ATOMIC_RELEASE);
+        stats_add(STATS_STAT, queued);
+        unsubmitted += queued;
+        if (done == count)
+            break;
+
+        // Submit what the kernel has not taken yet and wait for at
+        // least one completion.  A short submit leaves the rest in the
+        // ring for the next pass; EAGAIN/EBUSY just wait for requests
+        // already in flight to free up room.
+        int ret = uring_enter(r, unsubmitted, 1);
+        if (ret >= 0) {
+            unsubmitted -= (unsigned)ret;
+            in_flight += (unsigned)ret;
+        } else if ((errno != EAGAIN && errno != EBUSY) || in_flight == 0 ||
+                   uring_enter(r, 0, 1) < 0) {
+            failed = 1;
+            break;
+        }
+
+        unsigned reaped = reap_completions(&run);
+        in_flight -= reaped;
+        done += reaped;
+    }
+
+    int leak_bufs = 0;
+    if (failed) {
+        // The ring went bad mid-run.  Requests the kernel already took
+        // may still write into bufs, so wait them out before anything
+        // is freed; if even that fails, the buffers are never freed.
+        while (in_flight > 0 && uring_enter(r, 0, 1) >= 0)
+            in_flight -= reap_completions(&run);
+        leak_bufs = in_flight > 0;
+
+        // Finish the rest synchronously: every slot still taken (in
+        // flight or never submitted), then what was never queued
+        for (unsigned s = 0; s < depth; s++) {
+            int taken = 1;
+            for (unsigned f = 0; f < run.nfree; f++)
+                if (run.free_slots[f] == s) taken = 0;
+            if (taken) {
+                struct entry *e = &entries[run.slot_index[s]];
+                if (meta_fetch(dirfd, e->name, want, &e->meta) == -1)
+                    e->meta.error = errno;
+            }
+        }
+        for (int i = next; i < count; i++)
+            if (!entries[i].meta.valid && meta_fetch(dirfd, entries[i].name, want, &entries[i].meta) == -1)
+                entries[i].meta.error = errno;
+    }
+
+    uring_teardown(r);
+    if (!leak_bufs)
+        free(run.bufs);
+    free(run.slot_index);
+    free(run.free_slots);
+    return 0;
+}
+
+#else
+
+int uring_available(void) {
+    return 0;
+}
+
+int meta_fetch_all_uring(int dirfd, struct entry *entries, int count, unsigned want) {
+    (void)dirfd; (void)entries; (void)count; (void)want;
+    errno = ENOSYS;
+    return -1;
+}
+
+#endif
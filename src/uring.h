@@ -0,0 +1,22 @@
+/* ===========================================================
+ * uring.h - io_uring backend for bulk metadata collection
+ *
+ * Submits IORING_OP_STATX requests for a whole name array in rings
+ * of URING_QUEUE_DEPTH entries and reaps the completions in bulk.
+ * =========================================================== */
+#ifndef LSV_URING_H
+#define LSV_URING_H
+
+#include "entry.h"
+
+#define URING_QUEUE_DEPTH 256
+
+// Non-zero if the running kernel accepts io_uring_setup()
+int uring_available(void);
+
+// Same contract as meta_fetch_all().  Returns 0 when every slot was
+// filled, or -1 without touching entries when io_uring is unavailable,
+// so the caller can fall back to the synchronous path.
+int meta_fetch_all_uring(int dirfd, struct entry *entries, int count, unsigned want);
+
+#endif
@@ -0,0 +1,314 @@
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "walk.h"
+
+struct deque {
+    struct walk_node **items;        // ring buffer
+    size_t head;                     // oldest (steal end)
+    size_t count;
+    size_t capacity;
+    pthread_mutex_t lock;
+};
+
+struct walker {
+    struct deque *deques;
+    int nthreads;
+    walk_process_fn process;
+    void *arg;
+
+    pthread_mutex_t lock;            // guards sleeping and node->done
+    pthread_cond_t cond;
+    long queued;                     // nodes sitting in some deque
+    long outstanding;                // nodes queued or being processed
+};
+
+struct worker {
+    struct walker *w;
+    int id;
+};
+
+static struct walk_node *node_new(const char *path, size_t len) {
+    struct walk_node *n = calloc(1, sizeof(*n));
+    if (!n)
+        return NULL;
+    n->path = malloc(len + 1);
+    if (!n->path) {
+        free(n);
+        return NULL;
+    }
+    memcpy(n->path, path, len);
+    n->path[len] = '\0';
+    return n;
+}
+
+static void node_free(struct walk_node *n) {
+    free(n->path);
+    free(n->children);
+    free(n);
+}
+
+int walk_add_child(struct walk_node *parent, const char *name, size_t namelen) {
+    if (parent->nchildren >= parent->capacity) {
+        int capacity = parent->capacity ? parent->capacity * 2 : 8;
+        struct walk_node **children = realloc(parent->children, capacity * sizeof(*children));
+        if (!children)
+            return -1;
+        parent->children = children;
+        parent->capacity = capacity;
+    }
+
+    size_t plen = strlen(parent->path);
+    int slash = plen > 0 && parent->path[plen - 1] != '/';
+    char *path = malloc(plen + slash + namelen + 1);
+    if (!path)
+        return -1;
+    memcpy(path, parent->path, plen);
+    if (slash)
+        path[plen] = '/';
+    memcpy(path + plen + slash, name, namelen);
+    path[plen + slash + namelen] = '\0';
+
+    struct walk_node *child = calloc(1, sizeof(*child));
+    if (!child) {
+        free(path);
+        return -1;
+    }
+    child->path = path;
+    parent->children[parent->nchildren++] = child;
+    return 0;
+}
+
+// ==============================
+// Deques
+// ==============================
+
+static int deque_push_bottom(struct deque *d, struct walk_node *n) {
+    pthread_mutex_lock(&d->lock);
+    if (d->count == d->capacity) {
+        size_t capacity = d->capacity ? d->capacity * 2 : 64;
+        struct walk_node **items = malloc(capacity * sizeof(*items));
+        if (!items) {
+            pthread_mutex_unlock(&d->lock);
+            return -1;
+        }
+        for (size_t i = 0; i < d->count; i++)
+            items[i] = d->items[(d->head + i) % d->capacity];
+        free(d->items);
+        d->items = items;
+        d->head = 0;
+        d->capacity = capacity;
+    }
+    d->items[(d->head + d->count) % d->capacity] = n;
+    d->count++;
+    pthread_mutex_unlock(&d->lock);
+    return 0;
+}
+
+static struct walk_node *deque_pop_bottom(struct deque *d) {
+    struct walk_node *n = NULL;
+    pthread_mutex_lock(&d->lock);
+    if (d->count > 0) {
+        d->count--;
+        n = d->items[(d->head + d->count) % d->capacity];
+    }
+    pthread_mutex_unlock(&d->lock);
+    return n;
+}
+
+static struct walk_node *deque_steal_top(struct deque *d) {
+    struct walk_node *n = NULL;
+    pthread_mutex_lock(&d->lock);
+    if (d->count > 0) {
+        n = d->items[d->head];
+        d->head = (d->head + 1) % d->capacity;
+        d->count--;
+    }
+    pthread_mutex_unlock(&d->lock);
+    return n;
+}
+
+// ==============================
+// Workers
+// ==============================
+
+static struct walk_node *find_work(struct walker *w, int id) {
+    struct walk_node *n = deque_pop_bottom(&w->deques[id]);
+    for (int k = 1; !n && k < w->nthreads; k++)
+        n = deque_steal_top(&w->deques[(id + k) % w->nthreads]);
+    if (n)
+        __atomic_sub_fetch(&w->queued, 1, __ATOMIC_SEQ_CST);
+    return n;
+}
+
+static void finish_node(struct walker *w, int id, struct walk_node *n) {
+    // Children go on our own deque in reverse, so the first child is
+    // popped next and the emitter's next block is ready soonest
+    int pushed = 0;
+    for (int i = n->nchildren - 1; i >= 0; i--) {
+        if (deque_push_bottom(&w->deques[id], n->children[i]) == 0) {
+            pushed++;
+        } else {
+            // Out of memory: list it here instead of queueing it.  Its
+            // own finish_node() retires one outstanding node, so count it
+            pthread_mutex_lock(&w->lock);
+            w->outstanding++;
+            pthread_mutex_unlock(&w->lock);
+            w->process(n->children[i], w->arg);
+            finish_node(w, id, n->children[i]);
+        }
+    }
+
+    pthread_mutex_lock(&w->lock);
+    __atomic_add_fetch(&w->queued, pushed, __ATOMIC_SEQ_CST);
+    w->outstanding += pushed - 1;
+    n->done = 1;
+    pthread_cond_broadcast(&w->cond);
+    pthread_mutex_unlock(&w->lock);
+}
+
+static void *worker_main(void *arg) {
+    struct worker *self = arg;
+    struct walker *w = self->w;
+
+    for (;;) {
+        struct walk_node *n = find_work(w, self->id);
+        if (n) {
+            w->process(n, w->arg);
+            finish_node(w, self->id, n);
+            continue;
+        }
+
+        pthread_mutex_lock(&w->lock);
+        while (w->outstanding > 0 && __atomic_load_n(&w->queued, __ATOMIC_SEQ_CST) == 0)
+            pthread_cond_wait(&w->cond, &w->lock);
+        int finished = w->outstanding == 0;
+        pthread_mutex_unlock(&w->lock);
+        if (finished)
+            break;
+    }
+    return NULL;
+}
+
+static void walker_destroy(struct walker *w) {
+    for (int i = 0; i < w->nthreads; i++) {
+        pthread_mutex_destroy(&w->deques[i].lock);
+        free(w->deques[i].items);
+    }
+    free(w->deques);
+    pthread_cond_destroy(&w->cond);
+    pthread_mutex_destroy(&w->lock);
+}
+
+int walk_run(const char *const *roots, int nroots, int nthreads,
+             walk_process_fn process, walk_emit_fn emit, void *arg) {
+    if (nroots < 1)
+        return 0;
+    if (nthreads < 1) nthreads = 1;
+    if (nthreads > WALK_MAX_THREADS) nthreads = WALK_MAX_THREADS;
+
+    struct walk_node **tops = calloc(nroots, sizeof(*tops));
+    if (!tops)
+        return -1;
+    for (int i = 0; i < nroots; i++) {
+        tops[i] = node_new(roots[i], strlen(roots[i]));
+        if (!tops[i]) {
+            while (i-- > 0)
+                node_free(tops[i]);
+            free(tops);
+            return -1;
+        }
+    }
+
+    struct walker w = {
+        .nthreads = nthreads, .process = process, .arg = arg,
+        .queued = nroots, .outstanding = nroots,
+    };
+    w.deques = calloc(nthreads, sizeof(*w.deques));
+    if (!w.deques) {
+        for (int i = 0; i < nroots; i++)
+            node_free(tops[i]);
+        free(tops);
+        return -1;
+    }
+    pthread_mutex_init(&w.lock, NULL);
+    pthread_cond_init(&w.cond, NULL);
+    for (int i = 0; i < nthreads; i++)
+        pthread_mutex_init(&w.deques[i].lock, NULL);
+
+    // Deal the roots out round-robin, each deque in reverse, so every
+    // worker starts on the earliest roots it was given
+    int rc = 0;
+    for (int i = nroots - 1; i >= 0 && rc == 0; i--)
+        rc = deque_push_bottom(&w.deques[i % nthreads], tops[i]);
+    if (rc == -1) {
+        for (int i = 0; i < nroots; i++)
+            node_free(tops[i]);
+        free(tops);
+        walker_destroy(&w);
+        return -1;
+    }
+
+    pthread_t threads[WALK_MAX_THREADS];
+    struct worker workers[WALK_MAX_THREADS];
+    int started = 0;
+    for (; started < nthreads; started++) {
+        workers[started].w = &w;
+        workers[started].id = started;
+        if (pthread_create(&threads[started], NULL, worker_main, &workers[started]) != 0)
+            break;
+    }
+    if (started == 0) {
+        // No threads at all: walk inline, then emit below
+        workers[0].w = &w;
+        workers[0].id = 0;
+        worker_main(&workers[0]);
+    }
+
+    // Emit in pre-order: a node, then each child subtree in order
+    size_t depth = 0, cap = 64;
+    while (cap < (size_t)nroots)
+        cap *= 2;
+    struct walk_node **stack = malloc(cap * sizeof(*stack));
+    if (!stack)
+        rc = -1;
+    else
+        for (int i = nroots - 1; i >= 0; i--)
+            stack[depth++] = tops[i];
+
+    while (depth > 0) {
+        struct walk_node *n = stack[--depth];
+
+        pthread_mutex_lock(&w.lock);
+        while (!n->done)
+            pthread_cond_wait(&w.cond, &w.lock);
+        pthread_mutex_unlock(&w.lock);
+
+        emit(n, arg);
+
+        if (depth + n->nchildren > cap) {
+            while (depth + n->nchildren > cap)
+                cap *= 2;
+            struct walk_node **grown = realloc(stack, cap * sizeof(*stack));
+            if (!grown) {
+                // Cannot keep emitting in order; let the workers drain
+                rc = -1;
+                node_free(n);
+                break;
+            }
+            stack = grown;
+        }
+        for (int i = n->nchildren - 1; i >= 0; i--)
+            stack[depth++] = n->children[i];
+        node_free(n);
+    }
+    free(stack);
+    free(tops);
+
+    for (int t = 0; t < started; t++)
+        pthread_join(threads[t], NULL);
+
+    walker_destroy(&w);
+    return rc;
+}
@@ -0,0 +1,44 @@
+/* ===========================================================
+ * walk.h - Parallel recursive directory walker (-R)
+ *
+ * Pending directories sit in per-thread deques: a worker takes its
+ * newest directory from the bottom of its own deque and, when that
+ * is empty, steals the oldest one from the top of another worker's.
+ * Each directory is processed into a buffered result by a callback;
+ * the calling thread hands finished results to an emit callback in
+ * exactly the pre-order a serial ls -R would produce.  Several roots
+ * are walked as a forest, emitted in the order given.
+ * =========================================================== */
+#ifndef LSV_WALK_H
+#define LSV_WALK_H
+
+#include <stddef.h>
+
+#define WALK_MAX_THREADS 64
+
+struct walk_node {
+    char *path;
+    struct walk_node **children;     // subdirectories, in listing order
+    int nchildren;
+    int capacity;
+    void *result;                    // owned by the callbacks
+    int done;                        // set once process() has returned
+};
+
+// Runs on a worker thread; lists node->path into node->result and
+// calls walk_add_child() for each subdirectory in listing order.
+typedef void (*walk_process_fn)(struct walk_node *node, void *arg);
+
+// Runs on the calling thread, once per node, in serial ls -R order.
+// Must release node->result.
+typedef void (*walk_emit_fn)(struct walk_node *node, void *arg);
+
+// Queue parent/name for listing.  Returns 0 or -1 on allocation failure.
+int walk_add_child(struct walk_node *parent, const char *name, size_t namelen);
+
+// Walk the trees under roots[0..nroots) with nthreads workers.
+// Returns 0 or -1.
+int walk_run(const char *const *roots, int nroots, int nthreads,
+             walk_process_fn process, walk_emit_fn emit, void *arg);
+
+#endif
@@ -0,0 +1,50 @@
+#!/bin/sh
+# Regression checks for bin/lsv.
+#
+# Usage: check.sh <lsv binary> <liblsv.so> <embed binary>
+LSV=$1
+LIB=$2
+EMBED=$3
+TMP=$(mktemp -d)
+trap 'rm -rf "$TMP"' EXIT
+failed=0
+
+# expect <description> <pattern> <command...>: the output must contain pattern
+expect() {
+    what=$1 pattern=$2
+    shift 2
+    if "$@" 2>&1 | grep -qF -- "$pattern"; then
+        echo "ok   $what"
+    else
+        echo "FAIL $what"
+        failed=1
+    fi
+}
+
+ESC=$(printf '\033')
+printf '#!/bin/sh\n' > "$TMP/run.sh"
+chmod +x "$TMP/run.sh"
+unset LS_COLORS
+
+# -l stats every entry anyway, so executables are green without --mode-colors
+expect "-l colors executables" "${ESC}[0;32mrun.sh" "$LSV" -l "$TMP"
+expect "--mode-colors colors executables" "${ESC}[0;32mrun.sh" "$LSV" --mode-colors "$TMP"
+expect "plain listing colors from d_type" "${ESC}[0mrun.sh" "$LSV" "$TMP"
+
+# liblsv.so exports its API and nothing else
+if nm -D --defined-only "$LIB" | awk '{ print $3 }' | grep -v '^lsv_' | grep -q .; then
+    echo "FAIL liblsv.so exports only lsv_* symbols"
+    failed=1
+else
+    echo "ok   liblsv.so exports only lsv_* symbols"
+fi
+
+# A program linked against liblsv.so lists a directory
+if "$EMBED" "$TMP"; then
+    echo "ok   embed lists through liblsv.so"
+else
+    echo "FAIL embed lists through liblsv.so"
+    failed=1
+fi
+
+exit $failed
@@ -0,0 +1,77 @@
+// List a directory through liblsv.so and check the result against
+// the names readdir() returns.
+//
+// Usage: embed <dir>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+
+#include "lsv.h"
+
+static int failed_lookups;
+
+static void on_error(const char *name, int err, void *arg) {
+    (void)name;
+    (void)err;
+    (void)arg;
+    failed_lookups++;
+}
+
+int main(int argc, char *argv[]) {
+    if (argc != 2) {
+        fprintf(stderr, "usage: %s <dir>\n", argv[0]);
+        return 2;
+    }
+    int dirfd = open(argv[1], O_RDONLY | O_DIRECTORY);
+    if (dirfd == -1) {
+        perror(argv[1]);
+        return 2;
+    }
+
+    struct lsv_options opts = { .long_flag = 1, .jobs = 1, .show_all = 1,
+                                .on_error = on_error };
+    struct lsv_listing l;
+    struct outbuf out;
+
+    if (lsv_init(NULL, 0) == -1 || lsv_out_init_mem(&out, 0) == -1)
+        return 2;
+    lsv_listing_init(&l, &opts, NULL, 0);
+    if (lsv_scan(&l, dirfd) == -1) {
+        perror("lsv_scan");
+        return 1;
+    }
+    lsv_sort(&l);
+    if (lsv_render(&l, &out) == -1)
+        return 1;
+
+    // Every name readdir() sees is listed, and the rendered rows match
+    int expected = 0;
+    DIR *d = opendir(argv[1]);
+    struct dirent *de;
+    while (d && (de = readdir(d)))
+        expected++;
+    if (d)
+        closedir(d);
+
+    int rows = 0;
+    for (size_t i = 0; i < out.len; i++)
+        rows += out.buf[i] == '\n';
+
+    int status = 0;
+    if (lsv_count(&l) != expected) {
+        fprintf(stderr, "embed: %d entries, readdir saw %d\n", lsv_count(&l), expected);
+        status = 1;
+    }
+    if (rows + failed_lookups != lsv_count(&l)) {
+        fprintf(stderr, "embed: %d rows for %d entries\n", rows, lsv_count(&l));
+        status = 1;
+    }
+
+    lsv_listing_free(&l);
+    lsv_out_close(&out);
+    close(dirfd);
+    return status;
+}